@@ -0,0 +1,350 @@
+// Benchmarks for the CPU side of loading and preparing models. Needs no GL context.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+extern "C"
+{
+#include <getopt.h>
+#include <sys/stat.h>
+}
+
+#include "wavefront_obj.hpp"
+#include "png_image.hpp"
+#include "obj_generator.hpp"
+
+using namespace std;
+
+struct Result
+{
+	string name;
+	size_t bytes;
+	size_t triangles;
+	double seconds;
+};
+
+static size_t file_size(const string &path)
+{
+	struct stat info;
+	return (stat(path.c_str(), &info) == 0) ? info.st_size : 0;
+}
+
+/// Run the function until it has taken at least min_time and at least three times. Returns the fastest run.
+static double time_best(const function<void()> &fn, double min_time = 1.0)
+{
+	// Keep loader chatter out of the results and the timings
+	streambuf *saved = cout.rdbuf(nullptr);
+
+	double best = 1e30;
+	double total = 0.0;
+	for (int runs=0; runs<3 || total < min_time; runs++)
+	{
+		auto tp1 = chrono::steady_clock::now();
+		fn();
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - tp1;
+		best = min(best, elapsed.count());
+		total += elapsed.count();
+	}
+
+	cout.rdbuf(saved);
+	cout.clear();
+	return best;
+}
+
+static map<string, double> load_baseline(const char *path)
+{
+	map<string, double> baseline;
+	ifstream file(path);
+	string line;
+	getline(file, line); // header
+	while (getline(file, line))
+	{
+		// benchmark,bytes,triangles,seconds,mb_per_s,...
+		istringstream in(line);
+		string name, field;
+		getline(in, name, ',');
+		for (int i=0; i<4 && getline(in, field, ','); i++)
+		{
+			if (i == 3)
+			{
+				baseline[name] = atof(field.c_str());
+			}
+		}
+	}
+	return baseline;
+}
+
+static void display_help(const char *app_name)
+{
+	cout << "Usage: " << app_name << " <options>\n";
+	cout << "  --dir <dir> - directory for generated inputs (default bench_data).\n";
+	cout << "  --scale <factor> - multiply the size of every input.\n";
+	cout << "  --baseline <csv> - compare against the results of a previous run.\n";
+	cout << "  --save <csv> - save the results for use as a baseline.\n";
+	cout << "To only generate a model:\n";
+	cout << "  --generate <sphere|terrain|soup> --triangles <count> --out <obj file> [--seed <n>] [--no-tex-coords] [--no-normals]\n";
+}
+
+int main(int argc, char *argv[])
+{
+	static struct option long_options[] =
+	{
+		{"dir", required_argument, 0, 'd'},
+		{"scale", required_argument, 0, 's'},
+		{"baseline", required_argument, 0, 'b'},
+		{"save", required_argument, 0, 'o'},
+		{"generate", required_argument, 0, 'g'},
+		{"triangles", required_argument, 0, 't'},
+		{"out", required_argument, 0, 'f'},
+		{"seed", required_argument, 0, 'r'},
+		{"no-tex-coords", no_argument, 0, 'T'},
+		{"no-normals", no_argument, 0, 'N'},
+		{"help", no_argument, 0, 'h'},
+		{0, 0, 0, 0}
+	};
+
+	string dir = "bench_data";
+	double scale = 1.0;
+	const char *baseline_path = nullptr;
+	const char *save_path = nullptr;
+	bool generate_only = false;
+	const char *out_path = nullptr;
+	ObjGeneratorParams gen;
+
+	while (true)
+	{
+		int option_index = 0;
+		int c = getopt_long(argc, argv, "h", long_options, &option_index);
+
+		if (c == -1)
+		{
+			break;
+		}
+
+		switch (c)
+		{
+		case 'd':
+			dir = optarg;
+			break;
+		case 's':
+			scale = atof(optarg);
+			break;
+		case 'b':
+			baseline_path = optarg;
+			break;
+		case 'o':
+			save_path = optarg;
+			break;
+		case 'g':
+			generate_only = true;
+			if (!parse_obj_shape(optarg, gen.shape))
+			{
+				cerr << "Unknown shape: " << optarg << endl;
+				return 1;
+			}
+			break;
+		case 't':
+			gen.triangles = strtoul(optarg, nullptr, 10);
+			break;
+		case 'f':
+			out_path = optarg;
+			break;
+		case 'r':
+			gen.seed = strtoul(optarg, nullptr, 10);
+			break;
+		case 'T':
+			gen.tex_coords = false;
+			break;
+		case 'N':
+			gen.normals = false;
+			break;
+		default:
+			display_help(argv[0]);
+			return 1;
+		}
+	}
+
+	if (generate_only)
+	{
+		if (!out_path)
+		{
+			display_help(argv[0]);
+			return 1;
+		}
+		size_t triangles = generate_obj(out_path, gen);
+		cout << "Wrote " << triangles << " triangles to " << out_path << endl;
+		return triangles ? 0 : 1;
+	}
+
+	mkdir(dir.c_str(), 0755);
+	vector<Result> results;
+
+	// Loader throughput for each shape, with and without texture coords and normals.
+	// Inputs are only generated if they aren't there already.
+	const size_t triangles = static_cast<size_t>(200000 * scale);
+	const ObjShape shapes[] = { OBJ_SPHERE, OBJ_TERRAIN, OBJ_SOUP };
+	string sphere_path;
+	for (ObjShape shape : shapes)
+	{
+		for (int attributes=1; attributes>=0; attributes--)
+		{
+			ObjGeneratorParams params;
+			params.shape = shape;
+			params.triangles = triangles;
+			params.tex_coords = params.normals = (attributes != 0);
+
+			string name = string("parse_") + obj_shape_name(shape) + (attributes ? "_vt_vn" : "");
+			string path = dir + "/" + name.substr(6) + "_" + to_string(triangles) + "_v" + to_string(obj_generator_version) + ".obj";
+			if (file_size(path) == 0)
+			{
+				generate_obj(path.c_str(), params);
+			}
+			if (shape == OBJ_SPHERE && attributes)
+			{
+				sphere_path = path;
+			}
+
+			size_t parsed_triangles = 0;
+			double seconds = time_best([&]{
+				WavefrontObj object(path.c_str(), MESHLETS_NONE);
+				parsed_triangles = object.num_triangles();
+			});
+			results.push_back({ name, file_size(path), parsed_triangles, seconds });
+		}
+	}
+
+	// Per-frame and per-reload work on an already parsed model, in file order
+	WavefrontObj object(sphere_path.c_str(), MESHLETS_NONE);
+	const vector<float> &vertices = object.vertices();
+	const size_t vertex_bytes = vertices.size() * sizeof(float);
+
+	double seconds = time_best([&]{
+		volatile float scaler = WavefrontObj::compute_scaler(vertices);
+		(void)scaler;
+	});
+	results.push_back({ "compute_scaler", vertex_bytes, object.num_triangles(), seconds });
+
+	// Buffer preparation for a reload, with no changes and with a few scattered edits
+	vector<float> edited(vertices);
+	for (size_t i=0; i<edited.size(); i+=100000)
+	{
+		edited[i] += 1.0f;
+	}
+
+	vector<pair<size_t, size_t> > ranges;
+	seconds = time_best([&]{
+		ranges.clear();
+		WavefrontObj::changed_ranges(vertices, vertices, ranges);
+	});
+	results.push_back({ "buffer_diff_unchanged", vertex_bytes, object.num_triangles(), seconds });
+
+	seconds = time_best([&]{
+		ranges.clear();
+		WavefrontObj::changed_ranges(vertices, edited, ranges);
+	});
+	results.push_back({ "buffer_diff_sparse_edits", vertex_bytes, object.num_triangles(), seconds });
+
+	// Meshlet building on load and the per-frame cull from a camera looking at the sphere.
+	// Building sorts the arrays in place, so each run copies them in file order.
+	Meshlets meshlets;
+	seconds = time_best([&]{
+		vector<float> meshlet_vertices(vertices);
+		vector<float> meshlet_tex_coords(object.tex_coords());
+		vector<float> meshlet_normals(object.normals());
+		meshlets.build(meshlet_vertices, meshlet_tex_coords, meshlet_normals);
+	});
+	results.push_back({ "build_meshlets", vertex_bytes, object.num_triangles(), seconds });
+
+	// Column major perspective projection (45 degrees, 4:3) of the unit sphere seen from z = 3
+	const float f = 1.0f / tanf(3.14159265f / 8.0f);
+	const float near_plane = 0.1f, far_plane = 100.0f;
+	const float mvp[16] =
+	{
+		f / (4.0f / 3.0f), 0, 0, 0,
+		0, f, 0, 0,
+		0, 0, (far_plane + near_plane) / (near_plane - far_plane), -1,
+		0, 0, (far_plane + near_plane) / (near_plane - far_plane) * -3.0f + 2.0f * far_plane * near_plane / (near_plane - far_plane), 3.0f,
+	};
+	const float camera[3] = { 0.0f, 0.0f, 3.0f };
+
+	vector<int> draw_first, draw_count;
+	size_t drawn = 0;
+	seconds = time_best([&]{
+		drawn = meshlets.cull(mvp, camera, draw_first, draw_count);
+	});
+	results.push_back({ "cull_meshlets", meshlets.size() * 8 * sizeof(float), object.num_triangles(), seconds });
+	cerr << "Meshlets: " << meshlets.size() << ", culled " << 100.0 * (object.num_triangles() - drawn) / object.num_triangles()
+		 << "% of triangles with " << draw_first.size() << " draw ranges\n";
+
+	// PNG decoding, measured in decoded bytes
+	const int image_size = static_cast<int>(2048 * min(scale, 2.0));
+	string png_path = dir + "/texture_" + to_string(image_size) + ".png";
+	if (file_size(png_path) == 0)
+	{
+		generate_png(png_path.c_str(), image_size, image_size, 1);
+	}
+	seconds = time_best([&]{
+		PngImage image;
+		decode_png(png_path.c_str(), image, false);
+	});
+	results.push_back({ "decode_png", static_cast<size_t>(image_size) * image_size * 4, 0, seconds });
+
+	// Report
+	map<string, double> baseline;
+	if (baseline_path)
+	{
+		baseline = load_baseline(baseline_path);
+	}
+
+	ostringstream csv;
+	csv << "benchmark,bytes,triangles,seconds,mb_per_s,triangles_per_s";
+	csv << (baseline_path ? ",baseline_mb_per_s,change_pct\n" : "\n");
+	for (auto &result : results)
+	{
+		double mb_per_s = result.bytes / (1024.0 * 1024.0) / result.seconds;
+		char line[256];
+		snprintf(line, sizeof(line), "%s,%zu,%zu,%.6f,%.2f,%.0f", result.name.c_str(), result.bytes,
+				 result.triangles, result.seconds, mb_per_s, result.triangles / result.seconds);
+		csv << line;
+
+		if (baseline_path)
+		{
+			auto found = baseline.find(result.name);
+			if (found != baseline.end() && found->second > 0.0)
+			{
+				snprintf(line, sizeof(line), ",%.2f,%+.1f", found->second, (mb_per_s / found->second - 1.0) * 100.0);
+				csv << line;
+			}
+			else
+			{
+				csv << ",,";
+			}
+		}
+		csv << "\n";
+	}
+
+	cout << csv.str();
+
+	if (save_path)
+	{
+		ofstream file(save_path);
+		file << csv.str();
+		if (!file)
+		{
+			cerr << "Failed to save results to " << save_path << endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
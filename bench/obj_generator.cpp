@@ -0,0 +1,279 @@
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+extern "C"
+{
+// Includes for PNG
+#include <png.h>
+}
+
+#include "obj_generator.hpp"
+
+using namespace std;
+
+/// Small LCG so output doesn't depend on the standard library's distributions
+class Random
+{
+public:
+	Random(unsigned seed) : m_state(seed * 2654435761u + 1) {}
+
+	/// Uniform value in [0, 1)
+	float next()
+	{
+		m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<float>(m_state >> 40) / static_cast<float>(1 << 24);
+	}
+
+private:
+	unsigned long long m_state;
+};
+
+/// Writes the face line for a triangle in whichever of the OBJ index forms the params call for
+static void write_face(FILE *file, const ObjGeneratorParams &params, size_t a, size_t b, size_t c)
+{
+	if (params.tex_coords && params.normals)
+	{
+		fprintf(file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c);
+	}
+	else if (params.tex_coords)
+	{
+		fprintf(file, "f %zu/%zu %zu/%zu %zu/%zu\n", a, a, b, b, c, c);
+	}
+	else if (params.normals)
+	{
+		fprintf(file, "f %zu//%zu %zu//%zu %zu//%zu\n", a, a, b, b, c, c);
+	}
+	else
+	{
+		fprintf(file, "f %zu %zu %zu\n", a, b, c);
+	}
+}
+
+static void write_vertex(FILE *file, const ObjGeneratorParams &params, float x, float y, float z, float u, float v, float nx, float ny, float nz)
+{
+	fprintf(file, "v %.6f %.6f %.6f\n", x, y, z);
+	if (params.tex_coords)
+	{
+		fprintf(file, "vt %.6f %.6f\n", u, v);
+	}
+	if (params.normals)
+	{
+		fprintf(file, "vn %.6f %.6f %.6f\n", nx, ny, nz);
+	}
+}
+
+/// Grid of (rows + 1) x (cols + 1) vertices giving rows * cols * 2 triangles
+static void grid_size(size_t triangles, size_t &rows, size_t &cols)
+{
+	rows = max<size_t>(1, static_cast<size_t>(sqrt(triangles / 4.0)));
+	cols = max<size_t>(1, (triangles + 2 * rows - 1) / (2 * rows));
+}
+
+/// Triangulate the grid. Flip reverses the winding so the front faces point the other way.
+static size_t write_grid_faces(FILE *file, const ObjGeneratorParams &params, size_t rows, size_t cols, bool flip)
+{
+	for (size_t r=0; r<rows; r++)
+	{
+		for (size_t c=0; c<cols; c++)
+		{
+			// OBJ indices start at 1
+			size_t i0 = r * (cols + 1) + c + 1;
+			size_t i1 = i0 + 1;
+			size_t i2 = i0 + cols + 1;
+			size_t i3 = i2 + 1;
+			if (flip)
+			{
+				write_face(file, params, i0, i1, i2);
+				write_face(file, params, i1, i3, i2);
+			}
+			else
+			{
+				write_face(file, params, i0, i2, i1);
+				write_face(file, params, i1, i2, i3);
+			}
+		}
+	}
+	return rows * cols * 2;
+}
+
+static size_t generate_sphere(FILE *file, const ObjGeneratorParams &params)
+{
+	const float pi = 3.14159265358979f;
+	size_t stacks, slices;
+	grid_size(params.triangles, stacks, slices);
+
+	// Seams and poles are duplicated so every vertex has a single texture coordinate
+	for (size_t i=0; i<=stacks; i++)
+	{
+		float theta = pi * i / stacks;
+		for (size_t j=0; j<=slices; j++)
+		{
+			float phi = 2.0f * pi * j / slices;
+			float x = sinf(theta) * cosf(phi);
+			float y = cosf(theta);
+			float z = sinf(theta) * sinf(phi);
+			write_vertex(file, params, x, y, z, static_cast<float>(j) / slices, static_cast<float>(i) / stacks, x, y, z);
+		}
+	}
+
+	// Counter-clockwise seen from outside
+	return write_grid_faces(file, params, stacks, slices, true);
+}
+
+static size_t generate_terrain(FILE *file, const ObjGeneratorParams &params)
+{
+	Random random(params.seed);
+	size_t rows, cols;
+	grid_size(params.triangles, rows, cols);
+
+	// A few overlapping waves plus noise
+	float phase[4];
+	for (float &p : phase)
+	{
+		p = random.next() * 6.283f;
+	}
+
+	for (size_t r=0; r<=rows; r++)
+	{
+		for (size_t c=0; c<=cols; c++)
+		{
+			float u = static_cast<float>(c) / cols;
+			float v = static_cast<float>(r) / rows;
+			float h = 0.1f * sinf(u * 12.0f + phase[0]) * cosf(v * 9.0f + phase[1]) +
+				0.05f * sinf(u * 31.0f + phase[2] + v * 17.0f + phase[3]) +
+				0.01f * random.next();
+
+			// Approximate the normal from the slope of the main wave
+			float dx = 1.2f * cosf(u * 12.0f + phase[0]) * cosf(v * 9.0f + phase[1]);
+			float dz = -0.9f * sinf(u * 12.0f + phase[0]) * sinf(v * 9.0f + phase[1]);
+			float length = sqrtf(dx * dx + 1.0f + dz * dz);
+			write_vertex(file, params, u * 2.0f - 1.0f, h, v * 2.0f - 1.0f, u, v, -dx / length, 1.0f / length, -dz / length);
+		}
+	}
+
+	// Counter-clockwise seen from above
+	return write_grid_faces(file, params, rows, cols, false);
+}
+
+static size_t generate_soup(FILE *file, const ObjGeneratorParams &params)
+{
+	Random random(params.seed);
+
+	for (size_t t=0; t<params.triangles; t++)
+	{
+		float cx = random.next() * 2.0f - 1.0f;
+		float cy = random.next() * 2.0f - 1.0f;
+		float cz = random.next() * 2.0f - 1.0f;
+		for (int k=0; k<3; k++)
+		{
+			float x = cx + (random.next() - 0.5f) * 0.05f;
+			float y = cy + (random.next() - 0.5f) * 0.05f;
+			float z = cz + (random.next() - 0.5f) * 0.05f;
+			write_vertex(file, params, x, y, z, random.next(), random.next(), 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	for (size_t t=0; t<params.triangles; t++)
+	{
+		write_face(file, params, t * 3 + 1, t * 3 + 2, t * 3 + 3);
+	}
+
+	return params.triangles;
+}
+
+size_t generate_obj(const char *filename, const ObjGeneratorParams &params)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", filename);
+		return 0;
+	}
+
+	fprintf(file, "# Synthetic %s: %zu triangles, seed %u\n", obj_shape_name(params.shape), params.triangles, params.seed);
+
+	size_t triangles = 0;
+	switch (params.shape)
+	{
+	case OBJ_SPHERE:
+		triangles = generate_sphere(file, params);
+		break;
+	case OBJ_TERRAIN:
+		triangles = generate_terrain(file, params);
+		break;
+	case OBJ_SOUP:
+		triangles = generate_soup(file, params);
+		break;
+	}
+
+	fclose(file);
+	return triangles;
+}
+
+bool generate_png(const char *filename, int width, int height, unsigned seed)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", filename);
+		return false;
+	}
+
+	// A gradient with noise so the image compresses like a real texture rather than trivially
+	Random random(seed);
+	vector<png_byte> data(static_cast<size_t>(width) * height * 3);
+	vector<png_bytep> row_pointers(height);
+	for (int y=0; y<height; y++)
+	{
+		row_pointers[y] = &data[static_cast<size_t>(y) * width * 3];
+		for (int x=0; x<width; x++)
+		{
+			png_byte *pixel = row_pointers[y] + x * 3;
+			pixel[0] = static_cast<png_byte>(x * 255 / width);
+			pixel[1] = static_cast<png_byte>(y * 255 / height);
+			pixel[2] = static_cast<png_byte>(random.next() * 64.0f);
+		}
+	}
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : nullptr;
+	if (!info_ptr || setjmp(png_jmpbuf(png_ptr)))
+	{
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(file);
+		fprintf(stderr, "Failed to encode %s\n", filename);
+		return false;
+	}
+
+	png_init_io(png_ptr, file);
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB,
+				 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png_ptr, info_ptr);
+	png_write_image(png_ptr, row_pointers.data());
+	png_write_end(png_ptr, nullptr);
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(file);
+	return true;
+}
+
+static const char *shape_names[] = { "sphere", "terrain", "soup" };
+
+bool parse_obj_shape(const string &name, ObjShape &shape)
+{
+	for (int i=0; i<3; i++)
+	{
+		if (name == shape_names[i])
+		{
+			shape = static_cast<ObjShape>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *obj_shape_name(ObjShape shape)
+{
+	return shape_names[shape];
+}
@@ -0,0 +1,42 @@
+#ifndef __OBJ_GENERATOR_HPP__
+#define __OBJ_GENERATOR_HPP__
+
+#include <string>
+
+/**
+ * Deterministic generator for synthetic Wavefront OBJ files of configurable size.
+ *
+ * The same shape, size and seed always produce a byte-identical file, so results from
+ * different machines and builds can be compared.
+ */
+enum ObjShape
+{
+	OBJ_SPHERE,  // tessellated UV sphere
+	OBJ_TERRAIN, // height field on a regular grid
+	OBJ_SOUP,    // unconnected random triangles
+};
+
+/// Changed whenever the same parameters generate a different file, e.g. when a shape is fixed.
+/// Part of the names of cached inputs so they are regenerated.
+const int obj_generator_version = 2;
+
+struct ObjGeneratorParams
+{
+	ObjShape shape = OBJ_SPHERE;
+	size_t triangles = 100000;
+	bool tex_coords = true;
+	bool normals = true;
+	unsigned seed = 1;
+};
+
+/// Write the OBJ file. Returns the number of triangles written or 0 on failure.
+size_t generate_obj(const char *filename, const ObjGeneratorParams &params);
+
+/// Write a deterministic noisy RGB PNG. Returns false on failure.
+bool generate_png(const char *filename, int width, int height, unsigned seed);
+
+/// Parse a shape name as used on the command line.
+bool parse_obj_shape(const std::string &name, ObjShape &shape);
+const char *obj_shape_name(ObjShape shape);
+
+#endif // __OBJ_GENERATOR_HPP__
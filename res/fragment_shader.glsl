@@ -1,43 +1,118 @@
 #version 330 core
 
+// Features are injected by load_shaders() as #defines; see vertex_shader.glsl.
+
 // Interpolated values from the vertex shaders
+#ifdef TEXTURED
 in vec2 UV;
+#endif
+#ifdef LIT
 in vec3 normal;
 in vec3 vertex;
-in vec3 eye;
-in vec3 light;
+#endif
 
 out vec3 color;
 
 // Values that stay constant for the whole mesh.
+#ifdef TEXTURED
 uniform sampler2D Tex_Cube;
+#endif
+#ifdef LIGHT_LIST
+// Two texels per light: camera space position and radius, then colour
+uniform samplerBuffer Lights;
+uniform int Light_Count;
+#ifdef TILED
+// Offset and count into Light_Indices for each tile, row by row from the bottom left
+uniform usamplerBuffer Tile_Lists;
+uniform usamplerBuffer Light_Indices;
+uniform int Tiles_X;
+uniform int Tile_Size;
+#endif
+#endif
+#ifdef LIT
 uniform vec3 Light_Col;
 
+// Light position in camera space. The eye is at the origin of camera space.
+uniform vec3 Light_Pos;
+#endif
+
 void main()
 {
-	// Normal of fragment
+	// Base color of fragment
+#ifdef TEXTURED
+	vec3 base = texture( Tex_Cube, UV ).rgb;
+#else
+	vec3 base = vec3(0.8, 0.8, 0.8);
+#endif
+
+#ifdef LIGHT_LIST
 	vec3 norm = normalize(normal);
+	vec3 to_camera = normalize(-vertex);
+	color = base * 0.1;
 
-	// Normalized vector of light from fragment
-	vec3 to_light = normalize(light - vertex);
+#ifdef TILED
+	ivec2 tile = ivec2(gl_FragCoord.xy) / Tile_Size;
+	uvec2 list = texelFetch(Tile_Lists, tile.y * Tiles_X + tile.x).xy;
+	for (uint n = 0u; n < list.y; n++)
+	{
+		int index = int(texelFetch(Light_Indices, int(list.x + n)).x);
+#else
+	for (int index = 0; index < Light_Count; index++)
+	{
+#endif
+		vec4 light = texelFetch(Lights, index * 2);
+		vec3 to_light = light.xyz - vertex;
+		float distance_sq = dot(to_light, to_light);
+		if (distance_sq < light.w * light.w)
+		{
+			// Falls smoothly to zero at the light's radius
+			float falloff = 1.0 - distance_sq / (light.w * light.w);
+			falloff *= falloff;
+			to_light = normalize(to_light);
 
-	// Distance of light to fragment
-	float distance = length(light - vertex);
-	distance = 1.0;
+			vec3 light_col = texelFetch(Lights, index * 2 + 1).rgb;
+			float cos_angle = max(dot(norm, to_light), 0.0);
+			color += base * light_col * cos_angle * falloff;
+#ifdef SPECULAR
+			vec3 reflection = reflect(-to_light, norm);
+			float cos_alpha = max(dot(to_camera, reflection), 0.0);
+			color += light_col * pow(cos_alpha, 5.0) * falloff;
+#endif
+		}
+	}
+#else
+#ifdef LIT
+	// Normal of fragment
+	vec3 norm = normalize(normal);
 
-	// Calculate ambient color
-	vec3 ambient = vec3(0.1, 0.1, 0.1) * texture( Tex_Cube, UV ).rgb;
+	// Normalized vector of light from fragment
+	vec3 to_light = Light_Pos - vertex;
+#ifdef ATTENUATION
+	float attenuation = 1.0 / dot(to_light, to_light);
+#endif
+	to_light = normalize(to_light);
 
-	// Calculate diffuse color
-	float cos_angle = clamp(dot(norm, to_light), 0.0, 1.0);
-	vec3 diffuse = texture( Tex_Cube, UV ).rgb * cos_angle / (distance * distance);
+	// Calculate ambient and diffuse color
+	float cos_angle = max(dot(norm, to_light), 0.0);
+#ifdef ATTENUATION
+	cos_angle *= attenuation;
+#endif
+	color = base * (0.1 + cos_angle);
 
-	// Calculat specular color
-	vec3 to_camera = normalize(eye - vertex);
+#ifdef SPECULAR
+	// Calculate specular color
+	vec3 to_camera = normalize(-vertex);
 	vec3 reflection = reflect(-to_light, norm);
 
-	float cos_alpha = clamp(dot(to_camera, reflection), 0.0, 1.0);
-	vec3 specular = Light_Col * pow(cos_alpha, 5) / (distance * distance);
-
-	color = ambient + diffuse + specular;
+	float cos_alpha = max(dot(to_camera, reflection), 0.0);
+	float specular = pow(cos_alpha, 5.0);
+#ifdef ATTENUATION
+	specular *= attenuation;
+#endif
+	color += Light_Col * specular;
+#endif
+#else
+	color = base;
+#endif
+#endif
 }
@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 UV;
+in vec4 tint;
+
+out vec4 color;
+
+// Single channel glyph atlas
+uniform sampler2D Atlas;
+
+void main()
+{
+	color = vec4(tint.rgb, tint.a * texture( Atlas, UV ).r);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// Position in pixels from the top left of the viewport
+layout(location = 0) in vec2 vertexPosition_screen;
+layout(location = 1) in vec2 vertexUV;
+layout(location = 2) in vec4 vertexColor;
+
+uniform vec2 Screen_Size;
+
+out vec2 UV;
+out vec4 tint;
+
+void main()
+{
+	vec2 ndc = vertexPosition_screen / Screen_Size * 2.0 - 1.0;
+	gl_Position = vec4(ndc.x, -ndc.y, 0, 1);
+
+	UV = vertexUV;
+	tint = vertexColor;
+}
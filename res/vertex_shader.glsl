@@ -1,53 +1,61 @@
 #version 330 core
 
+// Features are injected by load_shaders() as #defines:
+//   TEXTURED    - mesh has texture coordinates
+//   LIT         - mesh has normals so lighting is applied
+//   SPECULAR    - add a specular highlight (requires LIT)
+//   ATTENUATION - attenuate light by distance (requires LIT)
+//   LIGHT_LIST  - shade with the list of point lights instead of the single light (requires LIT)
+//   TILED       - only loop over the lights binned to the fragment's screen tile (requires LIGHT_LIST)
+
 // Input vertex data, different for all executions of this shader.
 layout(location = 0) in vec3 vertexPosition_modelspace;
   
+#ifdef TEXTURED
 // The texture coordinates
 layout(location = 1) in vec2 vertexUV;
+#endif
 
+#ifdef LIT
 // The normal coordinates
 layout(location = 2) in vec3 vertexNormal;
+#endif
+
+// The depth pre-pass uses a different variant, so positions must match exactly
+invariant gl_Position;
 
 // Values that stay constant for the whole mesh.
-uniform mat4 MVP;	
-uniform mat4 M;	
-uniform mat4 V;	
-uniform vec3 Camera_Pos;
-uniform vec3 Light_Pos;
+uniform mat4 MVP;
+#ifdef LIT
+uniform mat4 MV;
+#endif
 
+#ifdef TEXTURED
 // Output tex coords
 out vec2 UV;
+#endif
 
+#ifdef LIT
 // Output normal
 out vec3 normal;
 
 // Output vertex
 out vec3 vertex;
-
-// Output eye
-out vec3 eye;
-
-// Output light
-out vec3 light;
+#endif
 
 void main()
 {
 	// Output position of the vertex, in clip space : MVP * position
 	gl_Position =  MVP * vec4(vertexPosition_modelspace,1);
 
+#ifdef TEXTURED
 	// UV of vertex
 	UV = vertexUV;
+#endif
 
-	// Normal
-	normal = (V * M * vec4(vertexNormal,0)).xyz;
-
-	// Vertex
-	vertex = (V * M * vec4(vertexPosition_modelspace,1)).xyz;
-
-	// Eye
-	eye = (V * vec4(Camera_Pos, 1)).xyz;
-
-	// Light
-	light = (V * vec4(Light_Pos, 1)).xyz;
+#ifdef LIT
+	// Normal and vertex in camera space
+	normal = (MV * vec4(vertexNormal,0)).xyz;
+	vertex = (MV * vec4(vertexPosition_modelspace,1)).xyz;
+#endif
 }
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+extern "C"
+{
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+}
+
+#include "asset_watcher.hpp"
+
+using namespace std;
+
+/// Exporters often write a file in several steps, so wait for it to settle before reloading
+static const chrono::milliseconds settle_time(100);
+
+AssetWatcher::AssetWatcher(const char *obj_path, const char *image_path)
+	: m_obj_path(obj_path), m_image_path(image_path), m_stop(false)
+{
+	m_thread = thread(&AssetWatcher::watch_thread, this);
+}
+
+AssetWatcher::~AssetWatcher()
+{
+	m_stop = true;
+	m_thread.join();
+}
+
+unique_ptr<WavefrontObj> AssetWatcher::take_object()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return move(m_object);
+}
+
+unique_ptr<PngImage> AssetWatcher::take_image()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return move(m_image);
+}
+
+void AssetWatcher::reload_object()
+{
+	auto tp1 = chrono::steady_clock::now();
+	// Kept in file order so the upload is only of what changed
+	unique_ptr<WavefrontObj> object(new WavefrontObj(m_obj_path, MESHLETS_FILE_ORDER));
+	chrono::duration<float, milli> elapsed = chrono::steady_clock::now() - tp1;
+
+	if (object->over_budget() != MEMORY_CATEGORIES)
+	{
+		cerr << "Reloaded " << m_obj_path << " is over the " << memory_category_name(object->over_budget())
+			 << " memory budget, keeping the current object\n";
+		return;
+	}
+	if (object->num_vertices() == 0)
+	{
+		cerr << "Reloaded " << m_obj_path << " has no faces, keeping the current object\n";
+		return;
+	}
+
+	cout << "Reloaded " << m_obj_path << " in " << elapsed.count() << " ms\n";
+	lock_guard<mutex> lock(m_mutex);
+	m_object = move(object);
+}
+
+void AssetWatcher::reload_image()
+{
+	unique_ptr<PngImage> image(new PngImage);
+	if (!decode_png(m_image_path, *image))
+	{
+		cerr << "Failed to reload " << m_image_path << ", keeping the current texture\n";
+		return;
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	m_image = move(image);
+}
+
+#ifdef __linux__
+
+/// Split a path into the directory to watch and the file name to match in its events
+static void split_path(const char *path, string &dir, string &name)
+{
+	string p(path);
+	size_t slash = p.rfind('/');
+	dir = (slash == string::npos) ? "." : p.substr(0, slash + 1);
+	name = (slash == string::npos) ? p : p.substr(slash + 1);
+}
+
+void AssetWatcher::watch_thread()
+{
+	int fd = inotify_init1(IN_NONBLOCK);
+	if (fd < 0)
+	{
+		cerr << "Failed to initialise inotify, live reload disabled\n";
+		return;
+	}
+
+	// Watch the directories rather than the files as many tools replace a file by
+	// writing a new one and renaming it over the old. Every write restarts the settle
+	// time, so a file written slowly isn't reloaded half finished.
+	const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY;
+	string obj_dir, obj_name, image_dir, image_name;
+	split_path(m_obj_path, obj_dir, obj_name);
+	split_path(m_image_path, image_dir, image_name);
+	int obj_wd = inotify_add_watch(fd, obj_dir.c_str(), mask);
+	int image_wd = inotify_add_watch(fd, image_dir.c_str(), mask);
+
+	bool obj_dirty = false;
+	bool image_dirty = false;
+	auto last_event = chrono::steady_clock::now();
+	alignas(inotify_event) char buffer[4096];
+
+	while (!m_stop)
+	{
+		pollfd pfd = { fd, POLLIN, 0 };
+		if (poll(&pfd, 1, 50) > 0)
+		{
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char *p = buffer; p < buffer + length; )
+				{
+					inotify_event *event = reinterpret_cast<inotify_event*>(p);
+					if (event->len > 0)
+					{
+						bool obj_event = (event->wd == obj_wd && obj_name == event->name);
+						bool image_event = (event->wd == image_wd && image_name == event->name);
+						if (obj_event || image_event)
+						{
+							last_event = chrono::steady_clock::now();
+						}
+						obj_dirty |= obj_event;
+						image_dirty |= image_event;
+					}
+					p += sizeof(inotify_event) + event->len;
+				}
+			}
+		}
+
+		if ((obj_dirty || image_dirty) && chrono::steady_clock::now() - last_event > settle_time)
+		{
+			if (obj_dirty)
+			{
+				reload_object();
+			}
+			if (image_dirty)
+			{
+				reload_image();
+			}
+			obj_dirty = image_dirty = false;
+		}
+	}
+
+	close(fd);
+}
+
+#else
+
+static chrono::system_clock::time_point modified_time(const char *path)
+{
+	struct stat info;
+	if (stat(path, &info) != 0)
+	{
+		return chrono::system_clock::time_point();
+	}
+	return chrono::system_clock::from_time_t(info.st_mtime);
+}
+
+void AssetWatcher::watch_thread()
+{
+	// No inotify so poll the modification times
+	auto obj_time = modified_time(m_obj_path);
+	auto image_time = modified_time(m_image_path);
+
+	while (!m_stop)
+	{
+		this_thread::sleep_for(settle_time);
+
+		auto time = modified_time(m_obj_path);
+		if (time != obj_time)
+		{
+			obj_time = time;
+			this_thread::sleep_for(settle_time);
+			reload_object();
+		}
+
+		time = modified_time(m_image_path);
+		if (time != image_time)
+		{
+			image_time = time;
+			this_thread::sleep_for(settle_time);
+			reload_image();
+		}
+	}
+}
+
+#endif
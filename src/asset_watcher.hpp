@@ -0,0 +1,50 @@
+#ifndef __ASSET_WATCHER_HPP__
+#define __ASSET_WATCHER_HPP__
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "wavefront_obj.hpp"
+#include "utility.hpp"
+
+/**
+ * Watches the model and texture files and reloads them on a background thread when they change.
+ *
+ * Uses inotify on Linux and polls modification times elsewhere. The render loop collects
+ * reloaded assets with take_object() and take_image() between frames; neither blocks.
+ */
+class AssetWatcher
+{
+public:
+	/// Constructors.
+	AssetWatcher(const char *obj_path, const char *image_path);
+
+	/// Destructors.
+	~AssetWatcher();
+
+	/// Return the reloaded object if there is one ready, otherwise null.
+	std::unique_ptr<WavefrontObj> take_object();
+
+	/// Return the reloaded image if there is one ready, otherwise null.
+	std::unique_ptr<PngImage> take_image();
+
+private:
+	void watch_thread();
+	void reload_object();
+	void reload_image();
+
+	/// Instance variables
+	const char *m_obj_path;
+	const char *m_image_path;
+
+	std::thread m_thread;
+	std::atomic<bool> m_stop;
+	std::mutex m_mutex;
+	std::unique_ptr<WavefrontObj> m_object;
+	std::unique_ptr<PngImage> m_image;
+};
+
+#endif // __ASSET_WATCHER_HPP__
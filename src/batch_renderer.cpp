@@ -0,0 +1,692 @@
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+
+#include <sys/stat.h>
+#include <dirent.h>
+}
+
+// Include GLM
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include "batch_renderer.hpp"
+
+using namespace std;
+
+/// Modification time of a file, or -1 if it doesn't exist
+static time_t modified_time(const string &path)
+{
+	struct stat st;
+	return (stat(path.c_str(), &st) == 0) ? st.st_mtime : -1;
+}
+
+static bool ends_with(const string &s, const string &suffix)
+{
+	return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Thumbnail path for a model path relative to the input, e.g. props/chair.obj -> output/props/chair.png.
+/// The input tree is mirrored so distinct models can't share a thumbnail. Manifest entries outside
+/// the manifest's directory go under _parent_ directories so they stay inside the output.
+static string thumbnail_path(const string &output, const string &relative)
+{
+	vector<string> parts;
+	istringstream in(relative);
+	string part;
+	while (getline(in, part, '/'))
+	{
+		if (part.empty() || part == ".")
+		{
+			continue;
+		}
+		else if (part == ".." && !parts.empty() && parts.back() != "_parent_")
+		{
+			parts.pop_back();
+		}
+		else
+		{
+			parts.push_back(part == ".." ? "_parent_" : part);
+		}
+	}
+
+	string path = output;
+	for (auto &p : parts)
+	{
+		path += "/" + p;
+	}
+	if (ends_with(path, ".obj"))
+	{
+		path.resize(path.size() - 4);
+	}
+	return path + ".png";
+}
+
+/// Create the directories leading up to a file
+static void make_parent_directories(const string &path)
+{
+	for (size_t slash = path.find('/', 1); slash != string::npos; slash = path.find('/', slash + 1))
+	{
+		mkdir(path.substr(0, slash).c_str(), 0755);
+	}
+}
+
+int BatchRenderer::run()
+{
+	m_size = max(1, m_options.thumbnailsize());
+	mkdir(m_options.batchoutput(), 0755);
+
+	if (!find_items())
+	{
+		return 1;
+	}
+
+	string log_path = string(m_options.batchoutput()) + "/failures.log";
+	m_failure_log.open(log_path, ofstream::app);
+
+	unsigned num_contexts = max(1, m_options.contexts());
+	unsigned num_loaders = m_options.jobs() > 0 ? m_options.jobs() : max(1u, thread::hardware_concurrency());
+	cout << "Rendering " << m_items.size() << " models at " << m_size << "x" << m_size << " with "
+		 << num_loaders << " loaders and " << num_contexts << " contexts\n";
+
+	if (!HeadlessContext::initialize())
+	{
+		return 1;
+	}
+
+	// Drawing goes to offscreen framebuffers, so the contexts need no window or display
+	vector<Context> contexts(num_contexts);
+	for (auto &context : contexts)
+	{
+		context.gl.reset(new HeadlessContext);
+		if (!context.gl->valid())
+		{
+			cerr << "Failed to create a GL context\n";
+			contexts.clear();
+			HeadlessContext::terminate();
+			return 1;
+		}
+	}
+
+	// GLEW's function pointers are shared, so initialise them once
+	if (!contexts[0].gl->make_current() || !HeadlessContext::load_functions())
+	{
+		cerr << "Failed to initialize GLEW\n";
+		contexts.clear();
+		HeadlessContext::terminate();
+		return 1;
+	}
+	HeadlessContext::release_current();
+
+	m_next_item = 0;
+	m_rendered = 0;
+	m_skipped = 0;
+	m_failed = 0;
+	m_max_ready = 2 * num_contexts;
+	m_loaders_running = num_loaders;
+
+	auto tp1 = chrono::steady_clock::now();
+
+	vector<thread> threads;
+	for (unsigned i=0; i<num_loaders; i++)
+	{
+		threads.push_back(thread(&BatchRenderer::load_thread, this));
+	}
+	for (auto &context : contexts)
+	{
+		threads.push_back(thread(&BatchRenderer::render_thread, this, ref(context)));
+	}
+
+	// Report progress until the render threads have drained the queue
+	auto finished = [this]() {
+		return m_rendered + m_skipped + m_failed >= m_items.size();
+	};
+	auto last_report = tp1;
+	while (!finished())
+	{
+		this_thread::sleep_for(chrono::milliseconds(100));
+
+		auto now = chrono::steady_clock::now();
+		if (now - last_report >= chrono::seconds(2))
+		{
+			chrono::duration<float> elapsed = now - tp1;
+			cout << "Rendered " << m_rendered << " of " << m_items.size() << " (" << m_skipped << " up to date, "
+				 << m_failed << " failed), " << m_rendered / elapsed.count() << " models/s\n";
+			last_report = now;
+		}
+	}
+
+	for (auto &t : threads)
+	{
+		t.join();
+	}
+
+	chrono::duration<float> elapsed = chrono::steady_clock::now() - tp1;
+	cout << "Rendered " << m_rendered << " models in " << elapsed.count() << " s, "
+		 << (elapsed.count() > 0.0f ? m_rendered / elapsed.count() : 0.0f) << " models/s. "
+		 << m_skipped << " were up to date and " << m_failed << " failed";
+	if (m_failed)
+	{
+		cout << ", see " << log_path;
+	}
+	cout << "\n";
+
+	contexts.clear();
+	HeadlessContext::terminate();
+
+	return m_failed;
+}
+
+bool BatchRenderer::find_items()
+{
+	string input = m_options.batch();
+	struct stat st;
+	if (stat(input.c_str(), &st) != 0)
+	{
+		cerr << "Batch input not found: " << input << "\n";
+		return false;
+	}
+
+	if (S_ISDIR(st.st_mode))
+	{
+		find_in_directory(input, "");
+		sort(m_items.begin(), m_items.end(), [](const BatchItem &a, const BatchItem &b) {
+			return a.obj_path < b.obj_path;
+		});
+	}
+	else
+	{
+		// Manifest of "model.obj [texture.png]" lines. Relative paths are relative to the manifest.
+		ifstream manifest(input);
+		string base = input.substr(0, input.find_last_of('/') + 1);
+		string line;
+		while (getline(manifest, line))
+		{
+			istringstream in(line);
+			string obj, image;
+			in >> obj >> image;
+			if (obj.empty() || obj[0] == '#')
+			{
+				continue;
+			}
+
+			BatchItem item;
+			item.obj_path = (obj[0] == '/') ? obj : base + obj;
+			item.image_path = image.empty() ? "" : (image[0] == '/') ? image : base + image;
+			item.out_path = thumbnail_path(m_options.batchoutput(), obj);
+			m_items.push_back(item);
+		}
+	}
+
+	if (m_items.empty())
+	{
+		cerr << "No models found in " << input << "\n";
+		return false;
+	}
+	return true;
+}
+
+void BatchRenderer::find_in_directory(const string &root, const string &relative)
+{
+	string path = relative.empty() ? root : root + "/" + relative;
+	DIR *dir = opendir(path.c_str());
+	if (!dir)
+	{
+		cerr << "Unable to read directory " << path << "\n";
+		return;
+	}
+
+	while (struct dirent *entry = readdir(dir))
+	{
+		string name = entry->d_name;
+		if (name.empty() || name[0] == '.')
+		{
+			continue;
+		}
+
+		string child = relative.empty() ? name : relative + "/" + name;
+		string child_path = root + "/" + child;
+		struct stat st;
+		if (stat(child_path.c_str(), &st) != 0)
+		{
+			continue;
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			find_in_directory(root, child);
+		}
+		else if (ends_with(name, ".obj"))
+		{
+			// The texture has the same name as the model, if there is one
+			BatchItem item;
+			item.obj_path = child_path;
+			string image_path = child_path.substr(0, child_path.size() - 4) + ".png";
+			item.image_path = (modified_time(image_path) >= 0) ? image_path : "";
+			item.out_path = thumbnail_path(m_options.batchoutput(), child);
+			m_items.push_back(item);
+		}
+	}
+	closedir(dir);
+}
+
+void BatchRenderer::fail(const string &path, const string &reason)
+{
+	m_failed++;
+
+	lock_guard<mutex> lock(m_log_mutex);
+	cerr << path << ": " << reason << "\n";
+	m_failure_log << path << ": " << reason << endl;
+}
+
+void BatchRenderer::load_thread()
+{
+	while (true)
+	{
+		size_t index = m_next_item++;
+		if (index >= m_items.size())
+		{
+			break;
+		}
+
+		const BatchItem &item = m_items[index];
+
+		// Resume by skipping thumbnails newer than their sources
+		time_t out_time = modified_time(item.out_path);
+		if (out_time >= 0 && out_time >= modified_time(item.obj_path) &&
+			(item.image_path.empty() || out_time >= modified_time(item.image_path)))
+		{
+			m_skipped++;
+			continue;
+		}
+
+		// Held by pointer as WavefrontObj keeps a pointer to the path
+		unique_ptr<Loaded> loaded(new Loaded);
+		loaded->item = item;
+
+		if (modified_time(item.obj_path) < 0)
+		{
+			fail(item.obj_path, "file not found");
+			continue;
+		}
+
+		string reason;
+		bool over_budget = false;
+		begin_load(false);
+		bool ok = load(*loaded, reason, over_budget);
+		end_load(false, ok);
+
+		// Models in flight hold part of the budgets, so wait for them to finish and try again
+		// alone. Only a model that can't fit by itself fails.
+		if (over_budget)
+		{
+			loaded->object.reset();
+			loaded->image.reset();
+			begin_load(true);
+			ok = load(*loaded, reason, over_budget);
+			end_load(true, ok);
+		}
+
+		if (!ok)
+		{
+			fail(item.obj_path, reason);
+			continue;
+		}
+
+		// Wait for space so loaders can't run far ahead of the contexts and fill memory
+		unique_lock<mutex> lock(m_mutex);
+		m_space_cond.wait(lock, [this]() { return m_ready.size() < m_max_ready; });
+		m_ready.push_back(move(loaded));
+		m_ready_cond.notify_one();
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	m_loaders_running--;
+	m_ready_cond.notify_all();
+}
+
+bool BatchRenderer::load(Loaded &loaded, string &reason, bool &over_budget)
+{
+	over_budget = false;
+	loaded.object.reset(new WavefrontObj(loaded.item.obj_path.c_str(), MESHLETS_NONE));
+	if (loaded.object->over_budget() != MEMORY_CATEGORIES)
+	{
+		reason = string("larger than the ") + memory_category_name(loaded.object->over_budget()) + " memory budget";
+		over_budget = true;
+		return false;
+	}
+	if (loaded.object->num_triangles() == 0)
+	{
+		reason = "no faces";
+		return false;
+	}
+
+	if (!loaded.item.image_path.empty())
+	{
+		loaded.image.reset(new PngImage);
+		if (!decode_png(loaded.item.image_path.c_str(), *loaded.image, m_options.verbose()))
+		{
+			over_budget = loaded.image->width > 0 && loaded.image->data.empty();
+			reason = over_budget ? "larger than the texture-cpu memory budget" : "could not decode " + loaded.item.image_path;
+			return false;
+		}
+	}
+	return true;
+}
+
+void BatchRenderer::begin_load(bool exclusive)
+{
+	unique_lock<mutex> lock(m_memory_mutex);
+	m_memory_cond.wait(lock, [this]() { return !m_exclusive; });
+	if (exclusive)
+	{
+		// Set first so no other load starts while this one waits
+		m_exclusive = true;
+		m_memory_cond.wait(lock, [this]() { return m_loading == 0 && m_in_flight == 0; });
+	}
+	m_loading++;
+}
+
+void BatchRenderer::end_load(bool exclusive, bool loaded)
+{
+	lock_guard<mutex> lock(m_memory_mutex);
+	m_loading--;
+	m_in_flight += loaded ? 1 : 0;
+	m_exclusive = m_exclusive && !exclusive;
+	m_memory_cond.notify_all();
+}
+
+void BatchRenderer::render_thread(Context &context)
+{
+	bool ok = context.gl->make_current() && create_framebuffer(context);
+	if (!ok)
+	{
+		cerr << "Failed to set up a context and framebuffer, this context will not render\n";
+	}
+
+	while (true)
+	{
+		unique_ptr<Loaded> loaded;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_ready_cond.wait(lock, [this]() { return !m_ready.empty() || m_loaders_running == 0; });
+			if (m_ready.empty())
+			{
+				break;
+			}
+			loaded = move(m_ready.front());
+			m_ready.pop_front();
+			m_space_cond.notify_one();
+		}
+
+		if (!ok)
+		{
+			fail(loaded->item.obj_path, "no framebuffer to render to");
+		}
+		else if (render(context, *loaded))
+		{
+			m_rendered++;
+		}
+
+		// Free the model before letting waiting loads know its memory is back
+		loaded.reset();
+		lock_guard<mutex> lock(m_memory_mutex);
+		m_in_flight--;
+		m_memory_cond.notify_all();
+	}
+
+	for (auto &program : context.programs)
+	{
+		glDeleteProgram(program.second);
+	}
+	glDeleteFramebuffers(1, &context.framebuffer);
+	glDeleteFramebuffers(1, &context.resolve_framebuffer);
+	GLuint renderbuffers[3] = { context.color, context.depth, context.resolve_color };
+	glDeleteRenderbuffers(3, renderbuffers);
+	glDeleteVertexArrays(1, &context.vertex_array);
+	context.shader_memory.set(0);
+
+	HeadlessContext::release_current();
+}
+
+bool BatchRenderer::create_framebuffer(Context &context)
+{
+	glGenVertexArrays(1, &context.vertex_array);
+	glBindVertexArray(context.vertex_array);
+
+	// Multisampled to match the viewer, resolved into a second framebuffer for readback
+	GLint max_samples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+	GLsizei samples = min(4, max_samples);
+
+	glGenRenderbuffers(1, &context.color);
+	glBindRenderbuffer(GL_RENDERBUFFER, context.color);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, m_size, m_size);
+	glGenRenderbuffers(1, &context.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, context.depth);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, m_size, m_size);
+
+	glGenFramebuffers(1, &context.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, context.color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, context.depth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		return false;
+	}
+
+	glGenRenderbuffers(1, &context.resolve_color);
+	glBindRenderbuffer(GL_RENDERBUFFER, context.resolve_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_size, m_size);
+
+	glGenFramebuffers(1, &context.resolve_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, context.resolve_framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, context.resolve_color);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		return false;
+	}
+
+	context.pixels.resize(static_cast<size_t>(m_size) * m_size * 4);
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+	glEnable(GL_CULL_FACE);
+	return true;
+}
+
+GLuint BatchRenderer::program(Context &context, unsigned features)
+{
+	for (auto &program : context.programs)
+	{
+		if (program.first == features)
+		{
+			return program.second;
+		}
+	}
+
+	// Contexts don't share programs. Build one at a time so they don't race to write
+	// the same program cache entry.
+	GLuint program_id;
+	{
+		lock_guard<mutex> lock(m_shader_mutex);
+		program_id = load_shaders("res/vertex_shader.glsl", "res/fragment_shader.glsl", features, m_options.shadercache());
+	}
+	context.programs.push_back(make_pair(features, program_id));
+	context.shader_memory.set(context.shader_memory.bytes() + program_size(program_id));
+	return program_id;
+}
+
+bool BatchRenderer::render(Context &context, Loaded &loaded)
+{
+	WavefrontObj &object = *loaded.object;
+
+	unsigned features = 0;
+	if (loaded.image && object.has_tex_coords())
+	{
+		features |= SHADER_TEXTURED;
+	}
+	if (object.has_normals())
+	{
+		features |= SHADER_LIT;
+		features |= m_options.specular() ? SHADER_SPECULAR : 0;
+		features |= m_options.attenuation() ? SHADER_ATTENUATION : 0;
+	}
+
+	GLuint program_id = program(context, features);
+	if (!program_id)
+	{
+		fail(loaded.item.obj_path, "shaders failed to build");
+		return false;
+	}
+
+	// Centre the model and scale it as the viewer does, then view it from the viewer's
+	// starting camera position
+	float lo[3] = { numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max() };
+	float hi[3] = { -numeric_limits<float>::max(), -numeric_limits<float>::max(), -numeric_limits<float>::max() };
+	const vector<float> &vertices = object.vertices();
+	for (size_t i=0; i<vertices.size(); i+=3)
+	{
+		for (int k=0; k<3; k++)
+		{
+			lo[k] = min(lo[k], vertices[i + k]);
+			hi[k] = max(hi[k], vertices[i + k]);
+		}
+	}
+	glm::vec3 center((lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, (lo[2] + hi[2]) * 0.5f);
+	float scaler = 1.732f / object.get_scaler();
+
+	glm::vec3 camera_pos(3, 2, 3);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(camera_pos, glm::vec3(0,0,0), glm::vec3(0,-1,0));
+	glm::mat4 model = glm::scale(glm::mat4(1), glm::vec3(scaler, scaler, scaler)) * glm::translate(glm::mat4(1), -center);
+	glm::mat4 model_view = view * model;
+	glm::mat4 mvp = projection * model_view;
+	glm::vec4 light_pos = view * glm::vec4(camera_pos, 1);
+	glm::vec3 light_col(1, 1, 1);
+
+	// Claim GPU memory before creating anything. Models in other contexts hold part of the
+	// budget, so wait for them unless the model can't fit by itself.
+	MemoryUsage mesh_memory(MEMORY_MESH_GPU);
+	MemoryUsage texture_memory(MEMORY_TEXTURE_GPU);
+	size_t texture_bytes = (features & SHADER_TEXTURED) ? texture_size(*loaded.image) : 0;
+	{
+		unique_lock<mutex> lock(m_memory_mutex);
+		while (true)
+		{
+			MemoryCategory over = MEMORY_CATEGORIES;
+			if (!mesh_memory.try_set(object.data_bytes()))
+			{
+				over = MEMORY_MESH_GPU;
+			}
+			else if (!texture_memory.try_set(texture_bytes))
+			{
+				over = MEMORY_TEXTURE_GPU;
+			}
+			if (over == MEMORY_CATEGORIES)
+			{
+				break;
+			}
+
+			// Hold nothing while waiting, so contexts can't block each other
+			mesh_memory.set(0);
+			texture_memory.set(0);
+			if (memory_current(over) == 0)
+			{
+				lock.unlock();
+				fail(loaded.item.obj_path, string("larger than the ") + memory_category_name(over) + " memory budget");
+				return false;
+			}
+			m_memory_cond.wait(lock);
+		}
+	}
+
+	GLuint buffers[3] = { object.create_vertex_buffer(), object.create_tex_coord_buffer(), object.create_normal_buffer() };
+	GLuint texture = (features & SHADER_TEXTURED) ? create_texture(*loaded.image) : 0;
+	if (!m_options.keepmeshdata())
+	{
+		object.release_data();
+	}
+
+	// The driver's sizes replace the estimates
+	mesh_memory.set(buffer_size(buffers[0]) + buffer_size(buffers[1]) + buffer_size(buffers[2]));
+	texture_memory.set(texture ? texture_size(texture) : 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, context.framebuffer);
+	glViewport(0, 0, m_size, m_size);
+	glClearColor(0.25f, 0.25f, 0.25f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	glUseProgram(program_id);
+	glUniformMatrix4fv(glGetUniformLocation(program_id, "MVP"), 1, GL_FALSE, &mvp[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(program_id, "MV"), 1, GL_FALSE, &model_view[0][0]);
+	glUniform3fv(glGetUniformLocation(program_id, "Light_Pos"), 1, &light_pos[0]);
+	glUniform3fv(glGetUniformLocation(program_id, "Light_Col"), 1, &light_col[0]);
+	glUniform1i(glGetUniformLocation(program_id, "Tex_Cube"), 0);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	const GLint sizes[3] = { 3, 2, 3 };
+	const bool enabled[3] = { true, (features & SHADER_TEXTURED) != 0, (features & SHADER_LIT) != 0 };
+	for (GLuint i=0; i<3; i++)
+	{
+		if (enabled[i])
+		{
+			glEnableVertexAttribArray(i);
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+			glVertexAttribPointer(i, sizes[i], GL_FLOAT, GL_FALSE, 0, (void*)0);
+		}
+		else
+		{
+			glDisableVertexAttribArray(i);
+		}
+	}
+
+	glDrawArrays(GL_TRIANGLES, 0, object.num_vertices());
+
+	// Resolve and read back
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, context.framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, context.resolve_framebuffer);
+	glBlitFramebuffer(0, 0, m_size, m_size, 0, 0, m_size, m_size, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, context.resolve_framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, m_size, m_size, GL_RGBA, GL_UNSIGNED_BYTE, context.pixels.data());
+
+	glDeleteBuffers(3, buffers);
+	if (texture)
+	{
+		glDeleteTextures(1, &texture);
+	}
+	{
+		lock_guard<mutex> lock(m_memory_mutex);
+		mesh_memory.set(0);
+		texture_memory.set(0);
+		m_memory_cond.notify_all();
+	}
+
+	// Write to a temporary file and rename so an interrupted run never leaves a partial
+	// thumbnail that would be taken as up to date
+	string tmp_path = loaded.item.out_path + ".tmp";
+	make_parent_directories(loaded.item.out_path);
+	if (!encode_png(tmp_path.c_str(), m_size, m_size, context.pixels.data()) ||
+		rename(tmp_path.c_str(), loaded.item.out_path.c_str()) != 0)
+	{
+		remove(tmp_path.c_str());
+		fail(loaded.item.obj_path, "could not write " + loaded.item.out_path);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,123 @@
+#ifndef __BATCH_RENDERER_HPP__
+#define __BATCH_RENDERER_HPP__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fstream>
+
+#include "options.hpp"
+#include "wavefront_obj.hpp"
+#include "utility.hpp"
+#include "headless_context.hpp"
+
+/// Model to render and where to write its thumbnail
+struct BatchItem
+{
+	std::string obj_path;
+	std::string image_path;    // empty if the model has no texture
+	std::string out_path;
+};
+
+/**
+ * Renders a thumbnail of every model in a directory or manifest.
+ *
+ * A pool of threads parses the models and decodes their textures. The results are
+ * queued for one or more headless GL contexts, each with its own render thread,
+ * which draw the model framed by its bounding box into an offscreen framebuffer and write
+ * a PNG. Models whose thumbnail is newer than the model and texture are skipped, so an
+ * interrupted run can be restarted. Models that fail are logged and skipped.
+ */
+class BatchRenderer
+{
+public:
+	/// Constructors.
+	BatchRenderer(const Options &options) : m_options(options) {}
+
+	/// Destructors.
+	~BatchRenderer() {}
+
+	/// Render every thumbnail. Returns the number of models that failed.
+	int run();
+
+private:
+	/// Model loaded and ready to draw
+	struct Loaded
+	{
+		BatchItem item;
+		std::unique_ptr<WavefrontObj> object;
+		std::unique_ptr<PngImage> image;
+	};
+
+	/// Per context GL state
+	struct Context
+	{
+		std::unique_ptr<HeadlessContext> gl;
+		GLuint vertex_array = 0;
+		GLuint framebuffer = 0;
+		GLuint color = 0;
+		GLuint depth = 0;
+		GLuint resolve_framebuffer = 0;
+		GLuint resolve_color = 0;
+		std::vector<std::pair<unsigned, GLuint> > programs;
+		std::vector<unsigned char> pixels;
+		MemoryUsage shader_memory{MEMORY_SHADERS};
+	};
+
+	/// Fill m_items from the directory or manifest. Returns false if it can't be read.
+	bool find_items();
+	void find_in_directory(const std::string &root, const std::string &relative);
+
+	void load_thread();
+	void render_thread(Context &context);
+
+	/// Parse the model and decode its texture. Returns false with the reason if it can't be
+	/// loaded, setting over_budget if a memory budget stopped it.
+	bool load(Loaded &loaded, std::string &reason, bool &over_budget);
+
+	/// Bracket a load. An exclusive load waits until no other model is loading or in flight.
+	void begin_load(bool exclusive);
+	void end_load(bool exclusive, bool loaded);
+
+	bool create_framebuffer(Context &context);
+	bool render(Context &context, Loaded &loaded);
+	GLuint program(Context &context, unsigned features);
+
+	void fail(const std::string &path, const std::string &reason);
+
+	/// Instance variables
+	const Options &m_options;
+	int m_size = 0;
+	std::vector<BatchItem> m_items;
+	std::atomic<size_t> m_next_item;
+
+	// Loaded models waiting for a context
+	std::mutex m_mutex;
+	std::condition_variable m_ready_cond;
+	std::condition_variable m_space_cond;
+	std::deque<std::unique_ptr<Loaded> > m_ready;
+	size_t m_max_ready = 0;
+	unsigned m_loaders_running = 0;
+
+	// Models over a memory budget wait for the models in flight to finish, then retry alone
+	std::mutex m_memory_mutex;
+	std::condition_variable m_memory_cond;
+	unsigned m_loading = 0;
+	unsigned m_in_flight = 0;
+	bool m_exclusive = false;
+
+	std::mutex m_log_mutex;
+	std::ofstream m_failure_log;
+	std::mutex m_shader_mutex;
+
+	std::atomic<unsigned> m_rendered;
+	std::atomic<unsigned> m_skipped;
+	std::atomic<unsigned> m_failed;
+};
+
+#endif // __BATCH_RENDERER_HPP__
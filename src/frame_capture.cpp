@@ -0,0 +1,185 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+extern "C"
+{
+// For creating the capture directory
+#include <sys/stat.h>
+}
+
+#include "frame_capture.hpp"
+#include "utility.hpp"
+
+using namespace std;
+
+FrameCapture::FrameCapture(const char *directory, int width, int height, unsigned num_buffers, unsigned num_threads)
+	: m_directory(directory), m_width(width), m_height(height), m_slots(num_buffers), m_max_jobs(2 * num_threads)
+{
+	mkdir(directory, 0755);
+
+	const size_t size = static_cast<size_t>(m_width) * m_height * 4;
+	for (auto &slot : m_slots)
+	{
+		glGenBuffers(1, &slot.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_memory.set(size * m_slots.size());
+
+	for (unsigned i=0; i<num_threads; i++)
+	{
+		m_threads.push_back(thread(&FrameCapture::encoder_thread, this));
+	}
+
+	cout << "Capturing frames to: " << m_directory << " (" << m_width << "x" << m_height << ")\n";
+}
+
+FrameCapture::~FrameCapture()
+{
+	harvest(true);
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+	for (auto &t : m_threads)
+	{
+		t.join();
+	}
+
+	for (auto &slot : m_slots)
+	{
+		glDeleteBuffers(1, &slot.pbo);
+	}
+
+	cout << "Capture: " << m_frames_written << " of " << m_frame << " frames written, "
+		 << m_dropped_readback << " dropped waiting on GPU readback, "
+		 << m_dropped_encoder << " dropped waiting on encoders";
+	if (m_write_errors)
+	{
+		cout << ", " << m_write_errors << " failed to write";
+	}
+	cout << endl;
+}
+
+void FrameCapture::capture()
+{
+	const unsigned frame = m_frame++;
+
+	harvest(false);
+
+	// Never wait for the GPU here. If the next buffer in the ring is still in flight
+	// the frame is dropped.
+	Slot &slot = m_slots[m_next_slot];
+	if (slot.fence)
+	{
+		m_dropped_readback++;
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	m_next_slot = (m_next_slot + 1) % m_slots.size();
+}
+
+void FrameCapture::harvest(bool wait)
+{
+	// Visit the slots oldest first so frames reach the encoders in order
+	for (size_t i=0; i<m_slots.size(); i++)
+	{
+		Slot &slot = m_slots[(m_next_slot + i) % m_slots.size()];
+		if (!slot.fence)
+		{
+			continue;
+		}
+
+		GLuint64 timeout = wait ? 1000000000ull : 0;
+		GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			if (wait)
+			{
+				m_dropped_readback++;
+				glDeleteSync(slot.fence);
+				slot.fence = 0;
+			}
+			continue;
+		}
+
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+
+		unique_lock<mutex> lock(m_mutex);
+		if (!wait && m_jobs.size() >= m_max_jobs)
+		{
+			m_dropped_encoder++;
+			continue;
+		}
+		m_cond.wait(lock, [this]{ return m_jobs.size() < m_max_jobs; });
+		lock.unlock();
+
+		Job job;
+		job.frame = slot.frame;
+		job.pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+		void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.pixels.size(), GL_MAP_READ_BIT);
+		if (data)
+		{
+			memcpy(job.pixels.data(), data, job.pixels.size());
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		if (!data)
+		{
+			m_dropped_readback++;
+			continue;
+		}
+
+		lock.lock();
+		m_jobs.push_back(move(job));
+		lock.unlock();
+		m_cond.notify_all();
+	}
+}
+
+void FrameCapture::encoder_thread()
+{
+	while (true)
+	{
+		unique_lock<mutex> lock(m_mutex);
+		m_cond.wait(lock, [this]{ return m_stop || !m_jobs.empty(); });
+		if (m_jobs.empty())
+		{
+			return;
+		}
+
+		Job job = move(m_jobs.front());
+		m_jobs.pop_front();
+		lock.unlock();
+		m_cond.notify_all();
+
+		bool written = write_png(job);
+
+		lock.lock();
+		written ? m_frames_written++ : m_write_errors++;
+	}
+}
+
+bool FrameCapture::write_png(const Job &job)
+{
+	char filename[32];
+	snprintf(filename, sizeof(filename), "/frame_%06u.png", job.frame);
+	string path = m_directory + filename;
+
+	return encode_png(path.c_str(), m_width, m_height, job.pixels.data());
+}
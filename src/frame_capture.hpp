@@ -0,0 +1,81 @@
+#ifndef __FRAME_CAPTURE_HPP__
+#define __FRAME_CAPTURE_HPP__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+}
+
+#include "memory_tracker.hpp"
+
+/**
+ * Captures the framebuffer to a directory of PNGs without stalling the render loop.
+ *
+ * Each frame is read back into one of a ring of pixel pack buffers. It is mapped a few
+ * frames later, once its fence has signalled, and handed to a pool of encoder threads.
+ * If no buffer is free or the encoders fall behind, the frame is dropped and counted.
+ */
+class FrameCapture
+{
+public:
+	/// Constructors.
+	FrameCapture(const char *directory, int width, int height, unsigned num_buffers = 3, unsigned num_threads = 2);
+
+	/// Destructors. Flushes outstanding readbacks and waits for the encoders to finish.
+	~FrameCapture();
+
+	/// Queue a readback of the current framebuffer. Call after drawing and before swapping.
+	void capture();
+
+private:
+	struct Slot
+	{
+		GLuint pbo = 0;
+		GLsync fence = 0;
+		unsigned frame = 0;
+	};
+
+	struct Job
+	{
+		std::vector<unsigned char> pixels;
+		unsigned frame;
+	};
+
+	/// Move any completed readbacks to the encoders. If wait is set, block until they complete.
+	void harvest(bool wait);
+
+	void encoder_thread();
+	bool write_png(const Job &job);
+
+	/// Instance variables
+	std::string m_directory;
+	int m_width;
+	int m_height;
+	unsigned m_frame = 0;
+
+	std::vector<Slot> m_slots;
+	size_t m_next_slot = 0;
+
+	std::vector<std::thread> m_threads;
+	std::deque<Job> m_jobs;
+	size_t m_max_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	bool m_stop = false;
+
+	unsigned m_frames_written = 0;
+	unsigned m_dropped_readback = 0;
+	unsigned m_dropped_encoder = 0;
+	unsigned m_write_errors = 0;
+	MemoryUsage m_memory{MEMORY_SCRATCH};
+};
+
+#endif // __FRAME_CAPTURE_HPP__
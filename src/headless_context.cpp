@@ -0,0 +1,237 @@
+#include <iostream>
+#include <cstring>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+}
+
+#include "headless_context.hpp"
+
+using namespace std;
+
+#ifdef __linux__
+
+static EGLDisplay s_display = EGL_NO_DISPLAY;
+static EGLConfig s_config = nullptr;
+static bool s_surfaceless = false;
+
+/// True if the space separated extension list contains name
+static bool has_extension(const char *extensions, const char *name)
+{
+	size_t length = strlen(name);
+	for (const char *p = extensions; p && (p = strstr(p, name)); p += length)
+	{
+		bool starts = (p == extensions || p[-1] == ' ');
+		bool ends = (p[length] == ' ' || p[length] == '\0');
+		if (starts && ends)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/// Find a display that doesn't need a display server, falling back to the default one
+static EGLDisplay open_display()
+{
+	// Client extensions are null if the EGL implementation doesn't support them
+	const char *client = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if (client && get_platform_display)
+	{
+		if (has_extension(client, "EGL_MESA_platform_surfaceless"))
+		{
+			EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (display != EGL_NO_DISPLAY)
+			{
+				return display;
+			}
+		}
+
+		auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+		EGLDeviceEXT device;
+		EGLint num_devices = 0;
+		if (has_extension(client, "EGL_EXT_platform_device") && query_devices &&
+			query_devices(1, &device, &num_devices) && num_devices > 0)
+		{
+			EGLDisplay display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+			if (display != EGL_NO_DISPLAY)
+			{
+				return display;
+			}
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool HeadlessContext::initialize()
+{
+	s_display = open_display();
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (s_display == EGL_NO_DISPLAY || !eglInitialize(s_display, &major, &minor))
+	{
+		cerr << "Failed to initialize EGL\n";
+		s_display = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	const EGLint config_attribs[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLint num_configs = 0;
+	if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(s_display, config_attribs, &s_config, 1, &num_configs) || num_configs == 0)
+	{
+		cerr << "EGL " << major << "." << minor << " has no desktop OpenGL support\n";
+		terminate();
+		return false;
+	}
+
+	// Drawing goes to framebuffer objects, so a surface is only made if the driver needs one
+	s_surfaceless = has_extension(eglQueryString(s_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+	return true;
+}
+
+void HeadlessContext::terminate()
+{
+	if (s_display != EGL_NO_DISPLAY)
+	{
+		eglTerminate(s_display);
+		s_display = EGL_NO_DISPLAY;
+	}
+}
+
+bool HeadlessContext::load_functions()
+{
+	// glewInit() also sets up GLX or EGL extensions through the windowing system, which
+	// fails when there is no display server. Only the GL functions are needed.
+	glewExperimental = true;
+	return glewContextInit() == GLEW_OK;
+}
+
+void HeadlessContext::release_current()
+{
+	// The API is per thread and the default is OpenGL ES
+	eglBindAPI(EGL_OPENGL_API);
+	eglMakeCurrent(s_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+HeadlessContext::HeadlessContext()
+{
+	const EGLint context_attribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+		EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+		EGL_NONE
+	};
+	eglBindAPI(EGL_OPENGL_API);
+	m_context = eglCreateContext(s_display, s_config, EGL_NO_CONTEXT, context_attribs);
+
+	if (m_context != EGL_NO_CONTEXT && !s_surfaceless)
+	{
+		const EGLint surface_attribs[] = { EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE };
+		m_surface = eglCreatePbufferSurface(s_display, s_config, surface_attribs);
+		if (m_surface == EGL_NO_SURFACE)
+		{
+			eglDestroyContext(s_display, m_context);
+			m_context = EGL_NO_CONTEXT;
+		}
+	}
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_surface != EGL_NO_SURFACE)
+	{
+		eglDestroySurface(s_display, m_surface);
+	}
+	if (m_context != EGL_NO_CONTEXT)
+	{
+		eglDestroyContext(s_display, m_context);
+	}
+}
+
+bool HeadlessContext::valid() const
+{
+	return m_context != EGL_NO_CONTEXT;
+}
+
+bool HeadlessContext::make_current()
+{
+	eglBindAPI(EGL_OPENGL_API);
+	return eglMakeCurrent(s_display, m_surface, m_surface, m_context) == EGL_TRUE;
+}
+
+#else
+
+bool HeadlessContext::initialize()
+{
+	if (!glfwInit())
+	{
+		cerr << "Failed to initialize GLFW\n";
+		return false;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	return true;
+}
+
+void HeadlessContext::terminate()
+{
+	glfwTerminate();
+}
+
+bool HeadlessContext::load_functions()
+{
+	glewExperimental = true;
+	return glewInit() == GLEW_OK;
+}
+
+void HeadlessContext::release_current()
+{
+	glfwMakeContextCurrent(NULL);
+}
+
+HeadlessContext::HeadlessContext()
+{
+	m_window = glfwCreateWindow(16, 16, "Batch", NULL, NULL);
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_window)
+	{
+		glfwDestroyWindow(m_window);
+	}
+}
+
+bool HeadlessContext::valid() const
+{
+	return m_window != nullptr;
+}
+
+bool HeadlessContext::make_current()
+{
+	glfwMakeContextCurrent(m_window);
+	return true;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __HEADLESS_CONTEXT_HPP__
+#define __HEADLESS_CONTEXT_HPP__
+
+#ifdef __linux__
+extern "C"
+{
+#include <EGL/egl.h>
+}
+#else
+struct GLFWwindow;
+#endif
+
+/**
+ * OpenGL 3.3 core context without a window, for rendering to framebuffer objects.
+ *
+ * On Linux the context is created with EGL, so no X or Wayland display is needed. Mesa's
+ * surfaceless platform is used if there is one, then the first EGL device, then the default
+ * display. All of these work with llvmpipe. Elsewhere a hidden GLFW window provides the context.
+ */
+class HeadlessContext
+{
+public:
+	/// Open the display shared by every context. Returns false if there is none.
+	static bool initialize();
+	static void terminate();
+
+	/// Load the GL functions. Call once with any context current, the functions are shared.
+	static bool load_functions();
+
+	/// Release the context current on the calling thread
+	static void release_current();
+
+	/// Constructors.
+	HeadlessContext();
+
+	/// Destructors.
+	~HeadlessContext();
+
+	bool valid() const;
+
+	/// Make the context current on the calling thread
+	bool make_current();
+
+private:
+	HeadlessContext(const HeadlessContext &) = delete;
+	HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+	/// Instance variables
+#ifdef __linux__
+	EGLContext m_context = EGL_NO_CONTEXT;
+	EGLSurface m_surface = EGL_NO_SURFACE;
+#else
+	GLFWwindow *m_window = nullptr;
+#endif
+};
+
+#endif // __HEADLESS_CONTEXT_HPP__
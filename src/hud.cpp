@@ -0,0 +1,430 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <cstddef>
+
+#include "hud.hpp"
+#include "utility.hpp"
+
+using namespace std;
+
+/// Characters in the glyph atlas. A solid cell used for the graph and background follows them.
+static const char atlas_chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/-%() ";
+
+/// 5x7 glyphs for atlas_chars, one byte per row from the top with the leftmost pixel in bit 4
+static const unsigned char atlas_glyphs[][7] =
+{
+	{ 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // 0
+	{ 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 1
+	{ 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // 2
+	{ 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // 3
+	{ 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // 4
+	{ 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // 5
+	{ 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // 6
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // 7
+	{ 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // 8
+	{ 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // 9
+	{ 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // A
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // B
+	{ 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // C
+	{ 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // D
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // E
+	{ 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // F
+	{ 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // G
+	{ 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // H
+	{ 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // I
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // J
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // K
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // L
+	{ 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // M
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // N
+	{ 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // O
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // P
+	{ 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // Q
+	{ 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // R
+	{ 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // S
+	{ 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // T
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // U
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // V
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // W
+	{ 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // X
+	{ 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // Y
+	{ 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // Z
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // .
+	{ 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // :
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // /
+	{ 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // -
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // %
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // (
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // )
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // space
+};
+
+static const int cell_width = 6;
+static const int cell_height = 8;
+static const int num_cells = sizeof(atlas_chars); // includes the solid cell in place of the terminator
+static const int atlas_width = num_cells * cell_width;
+static const float glyph_scale = 2.0f;
+
+static const chrono::milliseconds refresh_interval(250);
+
+const size_t Hud::num_samples;
+const size_t Hud::num_queries;
+
+static const unsigned char white[] = { 255, 255, 255, 255 };
+static const unsigned char panel[] = { 0, 0, 0, 160 };
+static const unsigned char green[] = { 64, 220, 64, 255 };
+static const unsigned char yellow[] = { 230, 200, 40, 255 };
+static const unsigned char red[] = { 230, 50, 50, 255 };
+
+Hud::~Hud()
+{
+	if (m_program)
+	{
+		glDeleteProgram(m_program);
+		glDeleteTextures(1, &m_texture);
+		glDeleteBuffers(1, &m_buffer);
+		glDeleteVertexArrays(1, &m_vertex_array);
+		glDeleteQueries(num_queries, m_queries);
+	}
+}
+
+void Hud::initialize()
+{
+	m_program = load_shaders("res/hud_vertex_shader.glsl", "res/hud_fragment_shader.glsl", 0, m_cache_dir);
+	m_screen_size_id = glGetUniformLocation(m_program, "Screen_Size");
+	m_atlas_id = glGetUniformLocation(m_program, "Atlas");
+
+	// Build the glyph atlas. GL rows run from the bottom so the glyphs are flipped.
+	vector<unsigned char> atlas(atlas_width * cell_height, 0);
+	for (int c=0; c<num_cells; c++)
+	{
+		for (int y=0; y<cell_height; y++)
+		{
+			for (int x=0; x<cell_width; x++)
+			{
+				bool set = (c == num_cells - 1) ||
+					(y < 7 && x < 5 && (atlas_glyphs[c][y] & (0x10 >> x)));
+				atlas[(cell_height - 1 - y) * atlas_width + c * cell_width + x] = set ? 255 : 0;
+			}
+		}
+	}
+
+	glGenTextures(1, &m_texture);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlas_width, cell_height, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	// Vertex layout for the batch
+	GLint previous_vertex_array = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vertex_array);
+
+	glGenVertexArrays(1, &m_vertex_array);
+	glBindVertexArray(m_vertex_array);
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, u));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, r));
+
+	glBindVertexArray(previous_vertex_array);
+
+	glGenQueries(num_queries, m_queries);
+}
+
+void Hud::set_visible(bool visible)
+{
+	if (visible && !m_visible)
+	{
+		// Start afresh rather than showing samples from before the HUD was hidden
+		m_num_samples = m_next_sample = 0;
+		m_num_gpu_samples = m_next_gpu_sample = 0;
+		m_query_head = m_query_tail = 0;
+		m_last_width = 0;
+	}
+	m_visible = visible;
+}
+
+void Hud::begin_frame()
+{
+	if (!m_visible || !m_program)
+	{
+		return;
+	}
+
+	m_cpu_start = chrono::steady_clock::now();
+
+	// Skip timing the GPU this frame if every query is still in flight
+	if (m_query_head - m_query_tail < num_queries)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_query_head % num_queries]);
+		m_query_active = true;
+	}
+}
+
+void Hud::end_frame()
+{
+	if (!m_visible || !m_program)
+	{
+		return;
+	}
+
+	if (m_query_active)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_query_head++;
+		m_query_active = false;
+	}
+
+	chrono::duration<float, milli> cpu_time = chrono::steady_clock::now() - m_cpu_start;
+	m_cpu_ms[m_next_sample] = cpu_time.count();
+
+	collect_gpu_times();
+}
+
+void Hud::add_frame_time(float ms)
+{
+	if (!m_visible)
+	{
+		return;
+	}
+
+	m_frame_ms[m_next_sample] = ms;
+	m_next_sample = (m_next_sample + 1) % num_samples;
+	m_num_samples = min(m_num_samples + 1, num_samples);
+}
+
+void Hud::collect_gpu_times()
+{
+	while (m_query_tail != m_query_head)
+	{
+		GLuint query = m_queries[m_query_tail % num_queries];
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+		m_query_tail++;
+
+		m_gpu_ms[m_next_gpu_sample] = elapsed_ns / 1.0e6f;
+		m_next_gpu_sample = (m_next_gpu_sample + 1) % num_samples;
+		m_num_gpu_samples = min(m_num_gpu_samples + 1, num_samples);
+	}
+}
+
+void Hud::add_quad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const unsigned char *color)
+{
+	const Vertex corners[] =
+	{
+		{ x0, y0, u0, v0, color[0], color[1], color[2], color[3] },
+		{ x0, y1, u0, v1, color[0], color[1], color[2], color[3] },
+		{ x1, y1, u1, v1, color[0], color[1], color[2], color[3] },
+		{ x1, y0, u1, v0, color[0], color[1], color[2], color[3] },
+	};
+
+	// Two triangles per quad
+	const int order[] = { 0, 1, 2, 0, 2, 3 };
+	for (int i : order)
+	{
+		m_batch.push_back(corners[i]);
+	}
+}
+
+void Hud::add_text(float x, float y, const string &text, const unsigned char *color)
+{
+	const float w = cell_width * glyph_scale;
+	const float h = cell_height * glyph_scale;
+
+	for (char c : text)
+	{
+		const char *found = strchr(atlas_chars, toupper(c));
+		if (found && c != '\0' && c != ' ')
+		{
+			float u0 = static_cast<float>((found - atlas_chars) * cell_width) / atlas_width;
+			float u1 = u0 + static_cast<float>(cell_width) / atlas_width;
+			add_quad(x, y, x + w, y + h, u0, 1.0f, u1, 0.0f, color);
+		}
+		x += w;
+	}
+}
+
+/// Format a size in bytes in the most readable unit
+static string format_bytes(size_t bytes)
+{
+	char text[32];
+	if (bytes >= 1024 * 1024)
+	{
+		snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "%.1f KB", bytes / 1024.0);
+	}
+	return text;
+}
+
+static float average(const float *samples, size_t count)
+{
+	float total = 0.0f;
+	for (size_t i=0; i<count; i++)
+	{
+		total += samples[i];
+	}
+	return count ? total / count : 0.0f;
+}
+
+void Hud::rebuild(int width, int height)
+{
+	m_batch.clear();
+
+	const float line_height = (cell_height + 2) * glyph_scale;
+	const float margin = 8.0f;
+	const float graph_height = 60.0f;
+	const float bar_width = 2.0f;
+	const float graph_width = num_samples * bar_width;
+	const float panel_width = max(graph_width, 40 * cell_width * glyph_scale) + 2 * margin;
+	const int num_lines = 5 + (m_streaming ? 2 : 0) + (m_lights ? 1 : 0);
+	const float panel_height = num_lines * line_height + graph_height + 3 * margin;
+
+	// Everything solid samples the middle of the solid cell
+	const float solid_u = (atlas_width - cell_width / 2.0f) / atlas_width;
+	const float solid_v = 0.5f;
+
+	add_quad(0, 0, panel_width, panel_height, solid_u, solid_v, solid_u, solid_v, panel);
+
+	float frame_ms = average(m_frame_ms, m_num_samples);
+	float max_frame_ms = m_num_samples ? *max_element(m_frame_ms, m_frame_ms + m_num_samples) : 0.0f;
+	char text[64];
+	float y = margin;
+
+	snprintf(text, sizeof(text), "FPS %.1f  FRAME %.2f MS  MAX %.2f MS", frame_ms > 0.0f ? 1000.0f / frame_ms : 0.0f, frame_ms, max_frame_ms);
+	add_text(margin, y, text, white);
+	y += line_height;
+
+	if (m_num_gpu_samples)
+	{
+		snprintf(text, sizeof(text), "CPU %.2f MS  GPU %.2f MS", average(m_cpu_ms, m_num_samples), average(m_gpu_ms, m_num_gpu_samples));
+	}
+	else
+	{
+		snprintf(text, sizeof(text), "CPU %.2f MS  GPU -", average(m_cpu_ms, m_num_samples));
+	}
+	add_text(margin, y, text, white);
+	y += line_height;
+
+	snprintf(text, sizeof(text), "VERTICES %zu  TRIANGLES %zu", m_vertices, m_triangles);
+	add_text(margin, y, text, white);
+	y += line_height;
+
+	snprintf(text, sizeof(text), "DRAWN %zu  CULLED %.1f%%", m_drawn_triangles,
+			 m_triangles ? 100.0 * (m_triangles - min(m_drawn_triangles, m_triangles)) / m_triangles : 0.0);
+	add_text(margin, y, text, white);
+	y += line_height;
+
+	add_text(margin, y, "VRAM BUFFERS " + format_bytes(m_buffer_bytes) + "  TEXTURES " + format_bytes(m_texture_bytes), white);
+	y += line_height;
+
+	if (m_streaming)
+	{
+		add_text(margin, y, "RESIDENT RAM " + format_bytes(m_stream_ram_bytes) + "  VRAM " + format_bytes(m_stream_vram_bytes), white);
+		y += line_height;
+
+		snprintf(text, sizeof(text), "IO %.1f MB/S  QUEUE %zu", m_io_mb_per_second, m_queue_depth);
+		add_text(margin, y, text, white);
+		y += line_height;
+	}
+
+	if (m_lights)
+	{
+		if (m_tiled)
+		{
+			snprintf(text, sizeof(text), "LIGHTS %zu  TILED %.1f PER TILE", m_lights, m_lights_per_tile);
+		}
+		else
+		{
+			snprintf(text, sizeof(text), "LIGHTS %zu  BRUTE FORCE", m_lights);
+		}
+		add_text(margin, y, text, white);
+		y += line_height;
+	}
+	y += margin;
+
+	// Frame time graph, oldest on the left. Full height is two 60Hz frames.
+	const float full_scale_ms = 33.3f;
+	for (size_t i=0; i<m_num_samples; i++)
+	{
+		size_t index = (m_next_sample + num_samples - m_num_samples + i) % num_samples;
+		float ms = m_frame_ms[index];
+		float h = min(ms / full_scale_ms, 1.0f) * graph_height;
+		const unsigned char *color = (ms <= 16.7f) ? green : (ms <= 33.3f) ? yellow : red;
+		float x = margin + i * bar_width;
+		add_quad(x, y + graph_height - h, x + bar_width, y + graph_height, solid_u, solid_v, solid_u, solid_v, color);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferData(GL_ARRAY_BUFFER, m_batch.size() * sizeof(Vertex), m_batch.data(), GL_STREAM_DRAW);
+
+	m_last_rebuild = chrono::steady_clock::now();
+	m_last_width = width;
+	m_last_height = height;
+}
+
+void Hud::draw(int width, int height)
+{
+	if (!m_visible)
+	{
+		return;
+	}
+
+	if (!m_program)
+	{
+		initialize();
+		if (!m_program)
+		{
+			cerr << "Failed to create HUD, hiding it\n";
+			m_visible = false;
+			return;
+		}
+	}
+
+	if (width != m_last_width || height != m_last_height ||
+		chrono::steady_clock::now() - m_last_rebuild >= refresh_interval)
+	{
+		rebuild(width, height);
+	}
+
+	// Draw over the scene without disturbing its state
+	GLint previous_vertex_array = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous_vertex_array);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(m_program);
+	glUniform2f(m_screen_size_id, static_cast<float>(width), static_cast<float>(height));
+	glUniform1i(m_atlas_id, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+
+	glBindVertexArray(m_vertex_array);
+	glDrawArrays(GL_TRIANGLES, 0, m_batch.size());
+
+	glBindVertexArray(previous_vertex_array);
+	glDisable(GL_BLEND);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+}
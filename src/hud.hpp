@@ -0,0 +1,122 @@
+#ifndef __HUD_HPP__
+#define __HUD_HPP__
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+}
+
+/**
+ * On-screen performance display.
+ *
+ * Frame, CPU and GPU times are recorded into ring buffers every frame while the HUD is
+ * visible. The text and frame time graph are only rebuilt a few times a second and are
+ * drawn from a glyph atlas with a single draw call. Nothing is recorded or drawn while
+ * the HUD is hidden.
+ */
+class Hud
+{
+public:
+	/// Constructors. GL resources are created the first time the HUD is shown.
+	Hud(const char *cache_dir) : m_cache_dir(cache_dir) {}
+
+	/// Destructors.
+	~Hud();
+
+	void set_visible(bool visible);
+	bool visible() const { return m_visible; }
+
+	/// Mark the start and end of the CPU work and GPU commands for a frame.
+	void begin_frame();
+	void end_frame();
+
+	/// Record the time between the last two frames.
+	void add_frame_time(float ms);
+
+	void set_geometry(size_t vertices, size_t triangles) { m_vertices = vertices; m_triangles = triangles; }
+	void set_drawn_triangles(size_t triangles) { m_drawn_triangles = triangles; }
+	void set_memory(size_t buffer_bytes, size_t texture_bytes) { m_buffer_bytes = buffer_bytes; m_texture_bytes = texture_bytes; }
+	void set_streaming(size_t ram_bytes, size_t vram_bytes, float io_mb_per_second, size_t queue_depth)
+	{
+		m_streaming = true;
+		m_stream_ram_bytes = ram_bytes;
+		m_stream_vram_bytes = vram_bytes;
+		m_io_mb_per_second = io_mb_per_second;
+		m_queue_depth = queue_depth;
+	}
+	void set_lights(size_t lights, bool tiled, float per_tile) { m_lights = lights; m_tiled = tiled; m_lights_per_tile = per_tile; }
+
+	/// Draw the HUD over the viewport of the given size in pixels.
+	void draw(int width, int height);
+
+private:
+	struct Vertex
+	{
+		float x, y;
+		float u, v;
+		unsigned char r, g, b, a;
+	};
+
+	/// Read back any GPU timer queries that have completed. Never waits.
+	void collect_gpu_times();
+
+	/// Rebuild the vertices for the text and graph from the recorded samples.
+	void rebuild(int width, int height);
+
+	void initialize();
+	void add_quad(float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, const unsigned char *color);
+	void add_text(float x, float y, const std::string &text, const unsigned char *color);
+
+	static const size_t num_samples = 120;
+	static const size_t num_queries = 4;
+
+	/// Instance variables
+	const char *m_cache_dir;
+	bool m_visible = false;
+	GLuint m_program = 0;
+	GLuint m_texture = 0;
+	GLuint m_vertex_array = 0;
+	GLuint m_buffer = 0;
+	GLint m_screen_size_id = -1;
+	GLint m_atlas_id = -1;
+
+	std::vector<Vertex> m_batch;
+	std::chrono::steady_clock::time_point m_last_rebuild;
+	int m_last_width = 0;
+	int m_last_height = 0;
+
+	float m_frame_ms[num_samples];
+	float m_cpu_ms[num_samples];
+	float m_gpu_ms[num_samples];
+	size_t m_num_samples = 0;
+	size_t m_next_sample = 0;
+	size_t m_num_gpu_samples = 0;
+	size_t m_next_gpu_sample = 0;
+
+	std::chrono::steady_clock::time_point m_cpu_start;
+	GLuint m_queries[num_queries];
+	size_t m_query_head = 0;
+	size_t m_query_tail = 0;
+	bool m_query_active = false;
+
+	size_t m_vertices = 0;
+	size_t m_triangles = 0;
+	size_t m_drawn_triangles = 0;
+	size_t m_buffer_bytes = 0;
+	size_t m_texture_bytes = 0;
+	bool m_streaming = false;
+	size_t m_stream_ram_bytes = 0;
+	size_t m_stream_vram_bytes = 0;
+	float m_io_mb_per_second = 0.0f;
+	size_t m_queue_depth = 0;
+	size_t m_lights = 0;
+	bool m_tiled = false;
+	float m_lights_per_tile = 0.0f;
+};
+
+#endif // __HUD_HPP__
@@ -0,0 +1,226 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "light_grid.hpp"
+
+using namespace std;
+
+const int LightGrid::tile_size;
+
+LightGrid::LightGrid(int width, int height)
+	: m_tiles_x((width + tile_size - 1) / tile_size), m_tiles_y((height + tile_size - 1) / tile_size),
+	  m_width(width), m_height(height)
+{
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &m_max_texels);
+
+	const GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+	glGenBuffers(3, m_buffers);
+	glGenTextures(3, m_textures);
+	for (int i=0; i<3; i++)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+		glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	cout << "Light grid: " << m_tiles_x << "x" << m_tiles_y << " tiles of " << tile_size << " pixels\n";
+}
+
+LightGrid::~LightGrid()
+{
+	glDeleteTextures(3, m_textures);
+	glDeleteBuffers(3, m_buffers);
+}
+
+void LightGrid::random_lights(size_t count, float extent, unsigned seed, vector<PointLight> &lights)
+{
+	// Small LCG so the layout is the same everywhere
+	unsigned long long state = seed * 2654435761ull + 1;
+	auto next = [&state]() {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return static_cast<float>(state >> 40) / static_cast<float>(1 << 24);
+	};
+
+	lights.resize(count);
+	for (auto &light : lights)
+	{
+		for (int k=0; k<3; k++)
+		{
+			light.position[k] = (next() * 2.0f - 1.0f) * extent;
+		}
+		light.radius = extent * (0.1f + 0.3f * next());
+
+		// Saturated colours so overlapping lights stay distinguishable
+		float hue = next() * 6.0f;
+		float x = 1.0f - fabsf(fmodf(hue, 2.0f) - 1.0f);
+		int sector = static_cast<int>(hue) % 6;
+		float rgb[6][3] = { {1, x, 0}, {x, 1, 0}, {0, 1, x}, {0, x, 1}, {x, 0, 1}, {1, 0, x} };
+		copy(rgb[sector], rgb[sector] + 3, light.color);
+	}
+}
+
+void LightGrid::update(const vector<PointLight> &lights, const float *projection, float near_plane, bool tiled)
+{
+	m_tiled = tiled;
+	m_num_lights = min(lights.size(), static_cast<size_t>(m_max_texels / 2));
+
+	// Two texels per light: position and radius, then colour
+	m_light_data.resize(m_num_lights * 8);
+	for (size_t i=0; i<m_num_lights; i++)
+	{
+		float *d = &m_light_data[i * 8];
+		copy(lights[i].position, lights[i].position + 3, d);
+		d[3] = lights[i].radius;
+		copy(lights[i].color, lights[i].color + 3, d + 4);
+		d[7] = 0.0f;
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[0]);
+	glBufferData(GL_TEXTURE_BUFFER, m_light_data.size() * sizeof(float), m_light_data.data(), GL_STREAM_DRAW);
+
+	if (!tiled)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		m_average = static_cast<float>(m_num_lights);
+		update_memory();
+		return;
+	}
+
+	// Find the tiles covered by each light from the projection of its bounding box.
+	// The camera looks down -z so lights with z - radius > -near are behind it.
+	const size_t num_tiles = static_cast<size_t>(m_tiles_x) * m_tiles_y;
+	m_rects.assign(m_num_lights * 4, 0);
+	m_tile_data.assign(num_tiles * 2, 0);
+
+	for (size_t i=0; i<m_num_lights; i++)
+	{
+		const PointLight &light = lights[i];
+		const float *c = light.position;
+		const float r = light.radius;
+		int *rect = &m_rects[i * 4];
+
+		if (c[2] - r > -near_plane)
+		{
+			// Empty rectangle
+			rect[0] = rect[1] = 0;
+			rect[2] = rect[3] = -1;
+			continue;
+		}
+
+		float lo[2] = { -1.0f, -1.0f };
+		float hi[2] = { 1.0f, 1.0f };
+		if (c[2] + r < -near_plane)
+		{
+			lo[0] = lo[1] = numeric_limits<float>::max();
+			hi[0] = hi[1] = -numeric_limits<float>::max();
+			for (int corner=0; corner<8; corner++)
+			{
+				float x = c[0] + ((corner & 1) ? r : -r);
+				float y = c[1] + ((corner & 2) ? r : -r);
+				float z = c[2] + ((corner & 4) ? r : -r);
+				float ndc[2] = { projection[0] * x / -z, projection[5] * y / -z };
+				for (int k=0; k<2; k++)
+				{
+					lo[k] = min(lo[k], ndc[k]);
+					hi[k] = max(hi[k], ndc[k]);
+				}
+			}
+		}
+
+		// To tiles, with y running up the screen as gl_FragCoord does
+		rect[0] = max(0, static_cast<int>((lo[0] * 0.5f + 0.5f) * m_width) / tile_size);
+		rect[1] = max(0, static_cast<int>((lo[1] * 0.5f + 0.5f) * m_height) / tile_size);
+		rect[2] = min(m_tiles_x - 1, static_cast<int>((hi[0] * 0.5f + 0.5f) * m_width) / tile_size);
+		rect[3] = min(m_tiles_y - 1, static_cast<int>((hi[1] * 0.5f + 0.5f) * m_height) / tile_size);
+
+		for (int y=rect[1]; y<=rect[3]; y++)
+		{
+			for (int x=rect[0]; x<=rect[2]; x++)
+			{
+				m_tile_data[(y * m_tiles_x + x) * 2 + 1]++;
+			}
+		}
+	}
+
+	// Offsets from the counts, then fill in the indices
+	size_t total = 0;
+	for (size_t t=0; t<num_tiles; t++)
+	{
+		m_tile_data[t * 2] = static_cast<GLuint>(total);
+		total += m_tile_data[t * 2 + 1];
+		m_tile_data[t * 2 + 1] = 0;
+	}
+
+	if (total > static_cast<size_t>(m_max_texels))
+	{
+		// Rare with real drivers, whose limits are far above the minimum the spec requires
+		cerr << "Light lists exceed GL_MAX_TEXTURE_BUFFER_SIZE, some lights will be missing\n";
+	}
+
+	m_indices.resize(min(total, static_cast<size_t>(m_max_texels)));
+	for (size_t i=0; i<m_num_lights; i++)
+	{
+		const int *rect = &m_rects[i * 4];
+		for (int y=rect[1]; y<=rect[3]; y++)
+		{
+			for (int x=rect[0]; x<=rect[2]; x++)
+			{
+				GLuint *tile = &m_tile_data[(y * m_tiles_x + x) * 2];
+				if (tile[0] + tile[1] < m_indices.size())
+				{
+					m_indices[tile[0] + tile[1]++] = static_cast<GLuint>(i);
+				}
+			}
+		}
+	}
+
+	m_average = num_tiles ? static_cast<float>(total) / num_tiles : 0.0f;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[1]);
+	glBufferData(GL_TEXTURE_BUFFER, m_tile_data.size() * sizeof(GLuint), m_tile_data.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[2]);
+	glBufferData(GL_TEXTURE_BUFFER, max<size_t>(m_indices.size(), 1) * sizeof(GLuint), m_indices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	update_memory();
+}
+
+void LightGrid::update_memory()
+{
+	size_t bytes = m_light_data.size() * sizeof(float) + (m_tile_data.size() + m_indices.size()) * sizeof(GLuint);
+	size_t cpu_bytes = m_light_data.capacity() * sizeof(float) + (m_tile_data.capacity() + m_indices.capacity()) * sizeof(GLuint)
+		+ m_rects.capacity() * sizeof(int);
+	m_memory.set(bytes + cpu_bytes);
+}
+
+void LightGrid::bind(GLuint program_id)
+{
+	if (program_id != m_program)
+	{
+		m_program = program_id;
+		m_lights_id = glGetUniformLocation(program_id, "Lights");
+		m_light_count_id = glGetUniformLocation(program_id, "Light_Count");
+		m_tile_lists_id = glGetUniformLocation(program_id, "Tile_Lists");
+		m_light_indices_id = glGetUniformLocation(program_id, "Light_Indices");
+		m_tiles_x_id = glGetUniformLocation(program_id, "Tiles_X");
+		m_tile_size_id = glGetUniformLocation(program_id, "Tile_Size");
+	}
+
+	for (int i=0; i<3; i++)
+	{
+		glActiveTexture(GL_TEXTURE1 + i);
+		glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	glUniform1i(m_lights_id, 1);
+	glUniform1i(m_tile_lists_id, 2);
+	glUniform1i(m_light_indices_id, 3);
+	glUniform1i(m_light_count_id, static_cast<GLint>(m_num_lights));
+	glUniform1i(m_tiles_x_id, m_tiles_x);
+	glUniform1i(m_tile_size_id, tile_size);
+}
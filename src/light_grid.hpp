@@ -0,0 +1,90 @@
+#ifndef __LIGHT_GRID_HPP__
+#define __LIGHT_GRID_HPP__
+
+#include <vector>
+#include <cstddef>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+}
+
+#include "memory_tracker.hpp"
+
+/// Point light with a finite range
+struct PointLight
+{
+	float position[3];
+	float radius;
+	float color[3];
+};
+
+/**
+ * Light lists for tiled forward shading.
+ *
+ * Each frame the lights are binned on the CPU into screen tiles by the projected bounds
+ * of their spheres. The lights, the per tile (offset, count) pairs and the packed light
+ * indices are uploaded to texture buffers so the fragment shader only loops over the
+ * lights that can reach its tile. Without tiling only the light buffer is uploaded and
+ * the shader loops over every light.
+ */
+class LightGrid
+{
+public:
+	static const int tile_size = 16;
+
+	/// Constructors.
+	LightGrid(int width, int height);
+
+	/// Destructors.
+	~LightGrid();
+
+	/// Generate a repeatable random layout of lights in a cube of the given half size around the origin.
+	static void random_lights(size_t count, float extent, unsigned seed, std::vector<PointLight> &lights);
+
+	/// Upload lights given in camera space. projection is the column major projection matrix.
+	void update(const std::vector<PointLight> &lights, const float *projection, float near_plane, bool tiled);
+
+	/// Bind the buffers to texture units 1 to 3 and set the uniforms for the program.
+	void bind(GLuint program_id);
+
+	/// Average number of lights per tile in the last update.
+	float average_lights_per_tile() const { return m_average; }
+
+private:
+	/// Account the CPU side arrays and their copies in the buffers
+	void update_memory();
+
+	/// Instance variables
+	int m_tiles_x;
+	int m_tiles_y;
+	int m_width;
+	int m_height;
+	GLint m_max_texels = 0;
+	bool m_tiled = false;
+	size_t m_num_lights = 0;
+	float m_average = 0.0f;
+
+	std::vector<float> m_light_data;
+	std::vector<GLuint> m_tile_data;
+	std::vector<GLuint> m_indices;
+	std::vector<int> m_rects;
+
+	// Buffer and texture for the lights, tiles and indices
+	GLuint m_buffers[3];
+	GLuint m_textures[3];
+
+	// Uniform locations for the last program bound
+	GLuint m_program = 0;
+	GLint m_lights_id = -1;
+	GLint m_light_count_id = -1;
+	GLint m_tile_lists_id = -1;
+	GLint m_light_indices_id = -1;
+	GLint m_tiles_x_id = -1;
+	GLint m_tile_size_id = -1;
+
+	MemoryUsage m_memory{MEMORY_SCRATCH};
+};
+
+#endif // __LIGHT_GRID_HPP__
@@ -3,6 +3,13 @@
 #include <string>
 #include <chrono>
 #include <cstring>
+#include <memory>
+#include <algorithm>
+
+extern "C"
+{
+#include <sys/stat.h>
+}
 
 extern "C"
 {
@@ -22,10 +29,20 @@ extern "C"
 #include "options.hpp"
 #include "utility.hpp"
 #include "wavefront_obj.hpp"
+#include "frame_capture.hpp"
+#include "asset_watcher.hpp"
+#include "hud.hpp"
+#include "light_grid.hpp"
+#include "streamed_model.hpp"
+#include "batch_renderer.hpp"
+#include "memory_tracker.hpp"
 
 using namespace std;
 
 float g_zoom = 3.0f;
+bool g_show_hud = false;
+bool g_cull = true;
+bool g_tiled = true;
 
 void scroll_callback(GLFWwindow *, double, double yoffset)
 {
@@ -41,15 +58,139 @@ void scroll_callback(GLFWwindow *, double, double yoffset)
 	}
 }
 
+void key_callback(GLFWwindow *, int key, int, int action, int)
+{
+	if (key == GLFW_KEY_H && action == GLFW_PRESS)
+	{
+		g_show_hud = !g_show_hud;
+	}
+	else if (key == GLFW_KEY_C && action == GLFW_PRESS)
+	{
+		g_cull = !g_cull;
+		cout << "Meshlet culling " << (g_cull ? "enabled" : "disabled") << endl;
+	}
+	else if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		g_tiled = !g_tiled;
+		cout << "Light lists " << (g_tiled ? "tiled" : "brute force") << endl;
+	}
+}
+
 void error_callback(int error, const char *desc)
 {
     cerr << "Error code: " << error << endl;
     cerr << desc << endl;
 }
 
+/// Pick the shader variant that matches the attributes the model actually has
+template <class Model>
+unsigned shader_features(const Model &object, const Options &options, bool tiled)
+{
+	unsigned features = 0;
+	if (object.has_tex_coords())
+	{
+		features |= SHADER_TEXTURED;
+	}
+	if (object.has_normals())
+	{
+		features |= SHADER_LIT;
+		features |= options.specular() ? SHADER_SPECULAR : 0;
+		features |= options.attenuation() ? SHADER_ATTENUATION : 0;
+		if (options.lights() > 0)
+		{
+			features |= SHADER_LIGHT_LIST;
+			features |= tiled ? SHADER_TILED : 0;
+		}
+	}
+	return features;
+}
+
+/// Uniform locations. Uniforms not used by the variant have a location of -1 and are ignored by glUniform*
+struct Uniforms
+{
+	Uniforms(GLuint program_id)
+		: mvp(glGetUniformLocation(program_id, "MVP")),
+		  mv(glGetUniformLocation(program_id, "MV")),
+		  light_pos(glGetUniformLocation(program_id, "Light_Pos")),
+		  light_col(glGetUniformLocation(program_id, "Light_Col")),
+		  tex(glGetUniformLocation(program_id, "Tex_Cube")) {}
+
+	GLint mvp;
+	GLint mv;
+	GLint light_pos;
+	GLint light_col;
+	GLint tex;
+};
+
+/// Switch to the shader variant for new_features, keeping the current program if the variant fails to build
+void switch_program(unsigned new_features, const Options &options, unsigned &features, GLuint &program_id, Uniforms &uniforms)
+{
+	GLuint new_program = load_shaders( "res/vertex_shader.glsl", "res/fragment_shader.glsl", new_features, options.shadercache() );
+	if (new_program)
+	{
+		glDeleteProgram(program_id);
+		program_id = new_program;
+		uniforms = Uniforms(program_id);
+	}
+
+	// Recorded even on failure so a broken variant isn't rebuilt every frame
+	features = new_features;
+}
+
+/// Open the chunk file for the model, building it first if it is missing or out of date
+unique_ptr<StreamedModel> load_streamed_model(const Options &options)
+{
+	string chunk_path = StreamedModel::chunk_path(options.chunkdir(), options.filepath());
+
+	mkdir(options.chunkdir(), 0755);
+	if (!StreamedModel::up_to_date(options.filepath(), chunk_path.c_str()))
+	{
+		cout << "Building " << chunk_path << "\n";
+		if (!StreamedModel::build(options.filepath(), chunk_path.c_str()))
+		{
+			return nullptr;
+		}
+	}
+
+	// Mesh memory budgets can only lower the cache sizes
+	const size_t mb = 1024 * 1024;
+	size_t ram_budget = options.rambudget() * mb;
+	size_t vram_budget = options.vrambudget() * mb;
+	if (memory_budget(MEMORY_MESH_CPU))
+	{
+		ram_budget = min(ram_budget, memory_budget(MEMORY_MESH_CPU));
+	}
+	if (memory_budget(MEMORY_MESH_GPU))
+	{
+		vram_budget = min(vram_budget, memory_budget(MEMORY_MESH_GPU));
+	}
+
+	unique_ptr<StreamedModel> model(new StreamedModel(chunk_path.c_str(), ram_budget, vram_budget));
+	if (!model->valid())
+	{
+		return nullptr;
+	}
+	return model;
+}
+
 int main(int argc, char *argv[])
 {
 	Options options(argc, argv);
+	if (!parse_memory_budgets(options.memorybudget()))
+	{
+		return -1;
+	}
+
+	// Batch mode renders thumbnails instead of opening the viewer
+	if (strlen(options.batch()) > 0)
+	{
+		BatchRenderer batch(options);
+		int failed = batch.run();
+		print_memory_summary(cout);
+		return failed ? 1 : 0;
+	}
+
+	g_cull = options.cull();
 	int width = options.width();
 	int height = options.height();
 
@@ -93,47 +234,171 @@ int main(int argc, char *argv[])
 	glGenVertexArrays(1, &vertex_array_id);
 	glBindVertexArray(vertex_array_id);
 
+	// Either load the whole model, or stream it from a chunk file built from it
 	cout << "Loading file: " << options.filepath() << endl;
-	WavefrontObj object(options.filepath());
-	if (options.verbose())
+	unique_ptr<WavefrontObj> object;
+	unique_ptr<StreamedModel> streamed;
+	if (strlen(options.chunkdir()) > 0)
+	{
+		streamed = load_streamed_model(options);
+		if (!streamed)
+		{
+			cerr << "Failed to load " << options.filepath() << " out of core. Aborting.\n";
+			abort();
+		}
+		cout << "Object has " << streamed->num_vertices() << " number of vertices, streamed from disk\n";
+	}
+	else
+	{
+		// Loading stops as soon as the next line would go over a budget. Reloads are diffed
+		// against the first load, so --watch keeps both in file order.
+		object.reset(new WavefrontObj(options.filepath(), options.watch() ? MESHLETS_FILE_ORDER : MESHLETS_SORTED));
+		if (object->over_budget() != MEMORY_CATEGORIES)
+		{
+			cerr << options.filepath() << " is over the " << memory_category_name(object->over_budget())
+				 << " memory budget, try --out-of-core. Aborting.\n";
+			abort();
+		}
+		if (options.verbose())
+		{
+			object->dump();
+		}
+		cout << "Object has " << object->num_vertices() << " number of vertices\n";
+
+		if (!memory_fits(MEMORY_MESH_GPU, object->data_bytes()))
+		{
+			cerr << options.filepath() << " is over the mesh-gpu memory budget, try --out-of-core. Aborting.\n";
+			abort();
+		}
+	}
+
+	GLuint vertex_buffer = object ? object->create_vertex_buffer() : 0;
+	GLuint uv_buffer = object ? object->create_tex_coord_buffer() : 0;
+	GLuint normal_buffer = object ? object->create_normal_buffer() : 0;
+
+	// Only the GPU copy is drawn. Reloads are diffed against the resident copy so --watch keeps it.
+	if (object && !options.keepmeshdata() && !options.watch())
 	{
-		object.dump();
+		object->release_data();
 	}
-	cout << "Object has " << object.num_vertices() << " number of vertices\n";
 
-	GLuint vertex_buffer = object.create_vertex_buffer();
-	GLuint uv_buffer = object.create_tex_coord_buffer();
-	GLuint normal_buffer = object.create_normal_buffer();
+	auto mesh_bytes = [&]()
+	{
+		return streamed ? streamed->stats().vram_bytes : buffer_size(vertex_buffer) + buffer_size(uv_buffer) + buffer_size(normal_buffer);
+	};
 
 	// Load texture
 	cout << "Using texture: " << options.imagepath() << "\n";
 	GLuint cube_texture = load_png(options.imagepath());
+	size_t texture_bytes = texture_size(cube_texture);
 
 	// Create and compile our GLSL program from the shaders
-	GLuint program_id = load_shaders( "res/vertex_shader.glsl", "res/fragment_shader.glsl" );
+	unsigned features = object ? shader_features(*object, options, g_tiled) : shader_features(*streamed, options, g_tiled);
+	GLuint program_id = load_shaders( "res/vertex_shader.glsl", "res/fragment_shader.glsl", features, options.shadercache() );
 	if (!program_id)
 	{
 		cerr << "Error detected when loading shaders. Aborting.\n";
 		abort();
 	}
 
+	Uniforms uniforms(program_id);
+
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
 	glEnable(GL_CULL_FACE);
 
 	glfwSetScrollCallback(window, scroll_callback);
+	glfwSetKeyCallback(window, key_callback);
 
 	double xpos = 0;
 	double ypos = 0;
 	float x_angle = 0.0;
 	float y_angle = 0.0;
 
-	char title[256];
-	snprintf(title, 256, "WIP - OpenGL Object Viewer");
-	glfwSetWindowTitle(window, title);
-	
+	// The title is set once. Updating it every frame costs a round trip to the window manager.
+	glfwSetWindowTitle(window, "WIP - OpenGL Object Viewer - press H for stats");
+
+	// The framebuffer size can differ from the window size
+	int fb_width, fb_height;
+	glfwGetFramebufferSize(window, &fb_width, &fb_height);
+
+	// Performance HUD, toggled with the H key
+	Hud hud(options.shadercache());
+	if (object)
+	{
+		hud.set_geometry(object->num_vertices(), object->num_triangles());
+	}
+	else
+	{
+		hud.set_geometry(streamed->num_vertices(), streamed->num_triangles());
+	}
+
+	// Account the GL objects the viewer owns. The streamed model accounts for its own chunks.
+	MemoryUsage mesh_memory(MEMORY_MESH_GPU);
+	MemoryUsage texture_memory(MEMORY_TEXTURE_GPU);
+	auto update_memory = [&]()
+	{
+		mesh_memory.set(object ? mesh_bytes() : 0);
+		texture_memory.set(texture_bytes);
+		hud.set_memory(mesh_bytes(), texture_bytes);
+	};
+	update_memory();
+
+	// Optionally capture frames
+	unique_ptr<FrameCapture> capture;
+	if (strlen(options.capturedir()) > 0)
+	{
+		capture.reset(new FrameCapture(options.capturedir(), fb_width, fb_height));
+	}
+
+	// Optionally reload the model and texture when they change on disk
+	unique_ptr<AssetWatcher> watcher;
+	if (options.watch() && streamed)
+	{
+		cerr << "--watch is not supported with --out-of-core, ignoring it\n";
+	}
+	else if (options.watch())
+	{
+		watcher.reset(new AssetWatcher(options.filepath(), options.imagepath()));
+	}
+
+	// Optionally light the object with many point lights. A depth pre-pass means the
+	// expensive lighting is only done once per pixel.
+	unique_ptr<LightGrid> light_grid;
+	vector<PointLight> lights;
+	vector<PointLight> camera_lights;
+	GLuint depth_program = 0;
+	GLint depth_mvp = -1;
+	if (options.lights() > 0)
+	{
+		light_grid.reset(new LightGrid(fb_width, fb_height));
+		LightGrid::random_lights(options.lights(), 1.0f, 1, lights);
+		camera_lights = lights;
+
+		depth_program = load_shaders( "res/vertex_shader.glsl", "res/fragment_shader.glsl", 0, options.shadercache() );
+		depth_mvp = glGetUniformLocation(depth_program, "MVP");
+		cout << "Lighting with " << lights.size() << " point lights, press L to toggle tiling\n";
+	}
+
+	MemoryUsage shader_memory(MEMORY_SHADERS);
+	shader_memory.set(program_size(program_id) + program_size(depth_program));
+	if (options.verbose())
+	{
+		print_memory_summary(cout);
+	}
+
+	// Visible meshlet ranges, reused every frame
+	vector<GLint> draw_first;
+	vector<GLsizei> draw_count;
+
 	auto tp1 = chrono::system_clock::now();
 	auto tp2 = chrono::system_clock::now();
+	float light_time = 0.0f;
+
+	// Frame times with and without tiled light lists, for the comparison printed at exit
+	double light_ms[2] = { 0.0, 0.0 };
+	size_t light_frames[2] = { 0, 0 };
+	const float near_plane = 0.1f;
 
 	auto camera_pos = glm::vec3(3, 2, 3);
 	auto light_pos = glm::vec3(3, 2, 3);
@@ -141,12 +406,74 @@ int main(int argc, char *argv[])
 
 	// The scaler returns the diagonal length of the bounding box of the object being viewed.
 	// Use this to try and create a scale value for the object to keep them reasonably scaled in the window.
-	auto scaler = 1.732f / object.get_scaler();
+	auto scaler = 1.732f / (object ? object->get_scaler() : streamed->get_scaler());
 
 	do
 	{
+		// Swap in any reloaded assets between frames
+		if (watcher)
+		{
+			unique_ptr<WavefrontObj> reloaded = watcher->take_object();
+			size_t mesh_growth = reloaded && reloaded->data_bytes() > mesh_bytes() ? reloaded->data_bytes() - mesh_bytes() : 0;
+			if (reloaded && !memory_fits(MEMORY_MESH_GPU, mesh_growth))
+			{
+				cerr << "Reloaded model is over the mesh-gpu memory budget, keeping the current one\n";
+			}
+			else if (reloaded)
+			{
+				auto upload_start = chrono::steady_clock::now();
+				size_t uploaded = reloaded->update_vertex_buffer(vertex_buffer, *object);
+				uploaded += reloaded->update_tex_coord_buffer(uv_buffer, *object);
+				uploaded += reloaded->update_normal_buffer(normal_buffer, *object);
+				chrono::duration<float, milli> upload_time = chrono::steady_clock::now() - upload_start;
+				cout << "Uploaded " << uploaded << " changed bytes in " << upload_time.count() << " ms\n";
+
+				object = move(reloaded);
+				scaler = 1.732f / object->get_scaler();
+
+				hud.set_geometry(object->num_vertices(), object->num_triangles());
+				update_memory();
+				if (options.verbose())
+				{
+					print_memory_summary(cout);
+				}
+			}
+
+			unique_ptr<PngImage> image = watcher->take_image();
+			size_t texture_growth = image && texture_size(*image) > texture_bytes ? texture_size(*image) - texture_bytes : 0;
+			if (image && !memory_fits(MEMORY_TEXTURE_GPU, texture_growth))
+			{
+				cerr << "Reloaded texture is over the texture-gpu memory budget, keeping the current one\n";
+			}
+			else if (image)
+			{
+				if (cube_texture)
+				{
+					update_texture(cube_texture, *image);
+				}
+				else
+				{
+					cube_texture = create_texture(*image);
+				}
+
+				texture_bytes = texture_size(cube_texture);
+				update_memory();
+			}
+		}
+
+		// Switch shader variant if a reload changed the attributes or the light lists were toggled
+		unsigned wanted_features = object ? shader_features(*object, options, g_tiled) : shader_features(*streamed, options, g_tiled);
+		if (wanted_features != features)
+		{
+			switch_program(wanted_features, options, features, program_id, uniforms);
+			shader_memory.set(program_size(program_id) + program_size(depth_program));
+		}
+
+		hud.set_visible(g_show_hud);
+		hud.begin_frame();
+
 		// Projection matrix : 45° Field of View, 4:3 ratio, display range : 0.1 unit <-> 100 units
-		glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float) width / (float)height, 0.1f, 100.0f);
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float) width / (float)height, near_plane, 100.0f);
   
 		// Or, for an ortho camera :
 		// glm::mat4 projection = glm::ortho(-2.0f,2.0f,-2.0f,2.0f,0.0f,100.0f); // In world coordinates
@@ -172,76 +499,153 @@ int main(int argc, char *argv[])
 		glClearColor(0.25f, 0.25f, 0.25f, 0.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Use our shader
-		glUseProgram(program_id);
+		// Find the chunks or meshlets to draw, skipping those off screen or facing away from the camera
+		glm::vec4 camera_model = glm::inverse(model) * glm::vec4(camera_pos, 1);
+		if (streamed)
+		{
+			hud.set_drawn_triangles(streamed->update(&mvp[0][0], &camera_model[0]));
 
-		// Set up uniforms
-		GLuint mvp_id = glGetUniformLocation(program_id, "MVP");
-		glUniformMatrix4fv(mvp_id, 1, GL_FALSE, &mvp[0][0]);
+			StreamStats stats = streamed->stats();
+			hud.set_streaming(stats.ram_bytes, stats.vram_bytes, stats.io_mb_per_second, stats.queue_depth);
+			hud.set_memory(stats.vram_bytes, texture_bytes);
+		}
+		else if (g_cull)
+		{
+			hud.set_drawn_triangles(object->meshlets().cull(&mvp[0][0], &camera_model[0], draw_first, draw_count));
+		}
+		else
+		{
+			hud.set_drawn_triangles(object->num_triangles());
+		}
 
-		GLuint m_id = glGetUniformLocation(program_id, "M");
-		glUniformMatrix4fv(m_id, 1, GL_FALSE, &model[0][0]);
+		auto draw_object = [&]()
+		{
+			if (streamed)
+			{
+				streamed->draw();
+			}
+			else if (g_cull)
+			{
+				glMultiDrawArrays(GL_TRIANGLES, draw_first.data(), draw_count.data(), draw_first.size());
+			}
+			else
+			{
+				glDrawArrays(GL_TRIANGLES, 0, object->num_vertices()); // Starting from vertex 0; 3 vertices total -> 1 triangle
+			}
+		};
+
+		// Orbit the lights about the vertical axis at a few different speeds and bin them in camera space
+		if (light_grid)
+		{
+			for (size_t i=0; i<lights.size(); i++)
+			{
+				float angle = light_time * (0.2f + 0.1f * (i % 8));
+				float c = cos(angle);
+				float s = sin(angle);
+				const float *p = lights[i].position;
+				glm::vec4 position = view * glm::vec4(p[0] * c + p[2] * s, p[1], p[2] * c - p[0] * s, 1);
+				camera_lights[i].position[0] = position.x;
+				camera_lights[i].position[1] = position.y;
+				camera_lights[i].position[2] = position.z;
+			}
+
+			bool tiled = (features & SHADER_TILED) != 0;
+			light_grid->update(camera_lights, &projection[0][0], near_plane, tiled);
+			hud.set_lights(lights.size(), tiled, light_grid->average_lights_per_tile());
+		}
 
-		GLuint v_id = glGetUniformLocation(program_id, "V");
-		glUniformMatrix4fv(v_id, 1, GL_FALSE, &view[0][0]);
+		// The streamed model sets up the attributes for each of its chunks
+		if (object)
+		{
+			// First attribute buffer : vertices
+			glEnableVertexAttribArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+			glVertexAttribPointer(
+				0,                  // attribute 0. No particular reason for 0, but must match the layout in the shader.
+				3,                  // size
+				GL_FLOAT,           // type
+				GL_FALSE,           // normalized?
+				0,                  // stride
+				(void*)0            // array buffer offset
+				);
+
+			// Second attribute buffer: texture coords
+			if (features & SHADER_TEXTURED)
+			{
+				glEnableVertexAttribArray(1);
+				glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
+				glVertexAttribPointer(
+					1,
+					2,
+					GL_FLOAT,
+					GL_TRUE,
+					0,
+					(void*)0
+					);
+			}
+
+			// Third attribute buffer: normals
+			if (features & SHADER_LIT)
+			{
+				glEnableVertexAttribArray(2);
+				glBindBuffer(GL_ARRAY_BUFFER, normal_buffer);
+				glVertexAttribPointer(
+					2,
+					3,
+					GL_FLOAT,
+					GL_TRUE,
+					0,
+					(void*)0
+					);
+			}
+		}
 
-		// Camera uniform
-		GLuint cam_pos_id = glGetUniformLocation(program_id, "Camera_Pos");
-		glUniform3fv(cam_pos_id, 1, &camera_pos[0]);
+		// Lay down depth first so only the visible surface is lit
+		if (depth_program)
+		{
+			glUseProgram(depth_program);
+			glUniformMatrix4fv(depth_mvp, 1, GL_FALSE, &mvp[0][0]);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			draw_object();
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			glDepthFunc(GL_LEQUAL);
+		}
 
-		// Light uniforms
-		GLuint light_pos_id = glGetUniformLocation(program_id, "Light_Pos");
-		glUniform3fv(light_pos_id, 1, &light_pos[0]);
+		// Use our shader
+		glUseProgram(program_id);
 
-		GLuint light_col_id = glGetUniformLocation(program_id, "Light_Col");
-		glUniform3fv(light_col_id, 1, &light_col[0]);
+		// Set up uniforms. Lighting is done in camera space so the products are formed once here
+		// rather than per vertex.
+		glm::mat4 model_view = view * model;
+		glm::vec4 light_pos_camera = view * glm::vec4(light_pos, 1);
 
-		// Texture uniform
-		GLuint tex_id = glGetUniformLocation(program_id, "Tex_Cube");
-		glUniform1i(tex_id, 0);
+		glUniformMatrix4fv(uniforms.mvp, 1, GL_FALSE, &mvp[0][0]);
+		glUniformMatrix4fv(uniforms.mv, 1, GL_FALSE, &model_view[0][0]);
+		glUniform3fv(uniforms.light_pos, 1, &light_pos_camera[0]);
+		glUniform3fv(uniforms.light_col, 1, &light_col[0]);
+		glUniform1i(uniforms.tex, 0);
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, cube_texture);
 
-		// First attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-		glVertexAttribPointer(
-			0,                  // attribute 0. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset
-			);
+		if (light_grid && (features & SHADER_LIGHT_LIST))
+		{
+			light_grid->bind(program_id);
+		}
 
-		// Second attribute buffer: texture coords
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
-		glVertexAttribPointer(
-			1,
-			2,
-			GL_FLOAT,
-			GL_TRUE,
-			0,
-			(void*)0
-			);
+		draw_object();
+		glDepthFunc(GL_LESS);
+		glDisableVertexAttribArray(0);
 
-		// Third attribute buffer: normals
-		glEnableVertexAttribArray(2);
-		glBindBuffer(GL_ARRAY_BUFFER, normal_buffer);
-		glVertexAttribPointer(
-			2,
-			3,
-			GL_FLOAT,
-			GL_TRUE,
-			0,
-			(void*)0
-			);
+		hud.end_frame();
 
-		// Draw the array
-		glDrawArrays(GL_TRIANGLES, 0, object.num_vertices()); // Starting from vertex 0; 3 vertices total -> 1 triangle
-		glDisableVertexAttribArray(0);
+		// Capture before drawing the HUD so it doesn't appear in the frames
+		if (capture)
+		{
+			capture->capture();
+		}
+
+		hud.draw(fb_width, fb_height);
 
 		// Swap buffers
 		glfwSwapBuffers(window);
@@ -251,10 +655,15 @@ int main(int argc, char *argv[])
 		tp2 = chrono::system_clock::now();
 		chrono::duration<float> elapsed_time = tp2 - tp1;
 		tp1 = tp2;
-		
-		char title[256];
-		snprintf(title, 256, "WIP - OpenGL Object Viewer - %3.f fps", 1.0 / elapsed_time.count());
-		glfwSetWindowTitle(window, title);
+
+		hud.add_frame_time(elapsed_time.count() * 1000.0f);
+		light_time += elapsed_time.count();
+		if (light_grid)
+		{
+			int mode = (features & SHADER_TILED) ? 1 : 0;
+			light_ms[mode] += elapsed_time.count() * 1000.0;
+			light_frames[mode]++;
+		}
 
 		// Move object based on mouse position relative to center
 		double old_xpos = xpos;
@@ -275,5 +684,31 @@ int main(int argc, char *argv[])
 	}
 	while (glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS && glfwWindowShouldClose(window) == 0);
 
+	if (light_grid)
+	{
+		const char *mode_names[2] = { "brute force", "tiled" };
+		for (int mode=0; mode<2; mode++)
+		{
+			if (light_frames[mode])
+			{
+				cout << "Average frame time with " << lights.size() << " lights " << mode_names[mode] << ": "
+					 << light_ms[mode] / light_frames[mode] << " ms over " << light_frames[mode] << " frames\n";
+			}
+		}
+	}
+
+	// Flush outstanding captures while the context is still current
+	capture.reset();
+	watcher.reset();
+	light_grid.reset();
+
+	if (streamed)
+	{
+		cout << "Streamed " << streamed->stats().bytes_read / (1024 * 1024) << " MB from disk\n";
+		streamed.reset();
+	}
+
+	print_memory_summary(cout);
+
 	return 0;
 }
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include "memory_tracker.hpp"
+
+using namespace std;
+
+static const char *category_names[MEMORY_CATEGORIES] =
+{
+	"mesh-cpu",
+	"mesh-gpu",
+	"texture-cpu",
+	"texture-gpu",
+	"shaders",
+	"scratch",
+};
+
+// Updated from the loader, I/O and render threads as well as the main thread
+static atomic<size_t> s_current[MEMORY_CATEGORIES];
+static atomic<size_t> s_peak[MEMORY_CATEGORIES];
+static atomic<size_t> s_budget[MEMORY_CATEGORIES];
+static atomic<bool> s_warned[MEMORY_CATEGORIES];
+
+const char *memory_category_name(MemoryCategory category)
+{
+	return category_names[category];
+}
+
+bool parse_memory_budgets(const char *budgets)
+{
+	istringstream in(budgets);
+	string entry;
+	while (getline(in, entry, ','))
+	{
+		size_t equals = entry.find('=');
+		if (equals == string::npos)
+		{
+			cerr << "Memory budget should be name=MB: " << entry << endl;
+			return false;
+		}
+
+		string name = entry.substr(0, equals);
+		string size = entry.substr(equals + 1);
+		char *end = nullptr;
+		unsigned long mb = strtoul(size.c_str(), &end, 10);
+		if (size.empty() || *end != '\0')
+		{
+			cerr << "Memory budget is not a number of MB: " << entry << endl;
+			return false;
+		}
+
+		int category = 0;
+		while (category < MEMORY_CATEGORIES && name != category_names[category])
+		{
+			category++;
+		}
+		if (category == MEMORY_CATEGORIES)
+		{
+			cerr << "Unknown memory category: " << name << endl;
+			return false;
+		}
+
+		set_memory_budget(static_cast<MemoryCategory>(category), static_cast<size_t>(mb) * 1024 * 1024);
+	}
+	return true;
+}
+
+size_t memory_budget(MemoryCategory category)
+{
+	return s_budget[category];
+}
+
+void set_memory_budget(MemoryCategory category, size_t bytes)
+{
+	s_budget[category] = bytes;
+}
+
+size_t memory_current(MemoryCategory category)
+{
+	return s_current[category];
+}
+
+size_t memory_peak(MemoryCategory category)
+{
+	return s_peak[category];
+}
+
+bool memory_fits(MemoryCategory category, size_t bytes)
+{
+	size_t budget = s_budget[category];
+	return budget == 0 || s_current[category] + bytes <= budget;
+}
+
+void print_memory_summary(ostream &out)
+{
+	const double mb = 1024.0 * 1024.0;
+	char line[128];
+
+	out << "Memory (MB)     current       peak     budget\n";
+	for (int i=0; i<MEMORY_CATEGORIES; i++)
+	{
+		char budget[32] = "-";
+		if (s_budget[i])
+		{
+			snprintf(budget, sizeof(budget), "%.1f", s_budget[i] / mb);
+		}
+		snprintf(line, sizeof(line), "  %-12s %10.1f %10.1f %10s\n", category_names[i], s_current[i] / mb, s_peak[i] / mb, budget);
+		out << line;
+	}
+}
+
+MemoryUsage &MemoryUsage::operator=(const MemoryUsage &other)
+{
+	if (this != &other)
+	{
+		set(0);
+		m_category = other.m_category;
+		set(other.m_bytes);
+	}
+	return *this;
+}
+
+bool MemoryUsage::try_set(size_t bytes)
+{
+	if (bytes == m_bytes)
+	{
+		return true;
+	}
+
+	size_t budget = s_budget[m_category];
+	if (bytes < m_bytes || budget == 0)
+	{
+		set(bytes);
+		return true;
+	}
+
+	// Claim the growth only if it fits, so threads can't both pass the check and go over together
+	size_t grow = bytes - m_bytes;
+	size_t current = s_current[m_category];
+	do
+	{
+		if (current + grow > budget)
+		{
+			return false;
+		}
+	}
+	while (!s_current[m_category].compare_exchange_weak(current, current + grow));
+
+	m_bytes = bytes;
+	size_t peak = s_peak[m_category];
+	while (current + grow > peak && !s_peak[m_category].compare_exchange_weak(peak, current + grow))
+	{
+	}
+	return true;
+}
+
+void MemoryUsage::set(size_t bytes)
+{
+	if (bytes < m_bytes)
+	{
+		s_current[m_category] -= m_bytes - bytes;
+		m_bytes = bytes;
+		return;
+	}
+
+	size_t total = (s_current[m_category] += bytes - m_bytes);
+	m_bytes = bytes;
+
+	size_t peak = s_peak[m_category];
+	while (total > peak && !s_peak[m_category].compare_exchange_weak(peak, total))
+	{
+	}
+
+	// Budgets are enforced by try_set() or memory_fits() before allocating. Anything that
+	// still goes over has no way to back out, so it is only reported.
+	size_t budget = s_budget[m_category];
+	if (budget && total > budget && !s_warned[m_category].exchange(true))
+	{
+		cerr << "Warning: " << category_names[m_category] << " memory is over its budget of "
+			 << budget / (1024 * 1024) << " MB\n";
+	}
+}
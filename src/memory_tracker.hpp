@@ -0,0 +1,71 @@
+#ifndef __MEMORY_TRACKER_HPP__
+#define __MEMORY_TRACKER_HPP__
+
+#include <cstddef>
+#include <ostream>
+
+/// Subsystems that memory is accounted to
+enum MemoryCategory
+{
+	MEMORY_MESH_CPU,
+	MEMORY_MESH_GPU,
+	MEMORY_TEXTURE_CPU,
+	MEMORY_TEXTURE_GPU,
+	MEMORY_SHADERS,
+	MEMORY_SCRATCH,
+	MEMORY_CATEGORIES
+};
+
+/// Name used in budgets and the summary, e.g. "mesh-gpu"
+const char *memory_category_name(MemoryCategory category);
+
+/// Set budgets from a comma separated list of name=MB, e.g. "mesh-gpu=256,texture-cpu=64".
+/// Returns false if a name or size isn't valid.
+bool parse_memory_budgets(const char *budgets);
+
+/// Budget in bytes, or 0 if the category has none
+size_t memory_budget(MemoryCategory category);
+void set_memory_budget(MemoryCategory category, size_t bytes);
+
+size_t memory_current(MemoryCategory category);
+size_t memory_peak(MemoryCategory category);
+
+/// True if bytes more would keep the category within its budget. Always true without a budget.
+bool memory_fits(MemoryCategory category, size_t bytes);
+
+/// Print the current, peak and budget of every category
+void print_memory_summary(std::ostream &out);
+
+/**
+ * Bytes held by an object, counted against a category for as long as the object lives.
+ *
+ * Copies are counted separately, so it can be a member of types that are copied.
+ */
+class MemoryUsage
+{
+public:
+	/// Constructors.
+	explicit MemoryUsage(MemoryCategory category) : m_category(category) {}
+	MemoryUsage(const MemoryUsage &other) : m_category(other.m_category) { set(other.m_bytes); }
+
+	/// Destructors.
+	~MemoryUsage() { set(0); }
+
+	MemoryUsage &operator=(const MemoryUsage &other);
+
+	/// Change the number of bytes held. Warns the first time the category goes over its budget.
+	void set(size_t bytes);
+
+	/// As set(), unless growing would take the category over its budget. Then it returns false
+	/// and changes nothing. Call before allocating.
+	bool try_set(size_t bytes);
+
+	size_t bytes() const { return m_bytes; }
+
+private:
+	/// Instance variables
+	MemoryCategory m_category;
+	size_t m_bytes = 0;
+};
+
+#endif // __MEMORY_TRACKER_HPP__
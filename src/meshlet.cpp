@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "meshlet.hpp"
+
+using namespace std;
+
+const size_t Meshlets::max_triangles;
+
+/// Spread the low 10 bits of v out to every third bit
+static uint32_t spread_bits(uint32_t v)
+{
+	v &= 0x3ff;
+	v = (v | (v << 16)) & 0x030000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+/// Unit face normal following GL's default counter-clockwise front faces. Zero for degenerate triangles.
+static void face_normal(const float *v, float *n)
+{
+	float e1[3] = { v[3] - v[0], v[4] - v[1], v[5] - v[2] };
+	float e2[3] = { v[6] - v[0], v[7] - v[1], v[8] - v[2] };
+	n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+	float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+	n[0] *= scale;
+	n[1] *= scale;
+	n[2] *= scale;
+}
+
+/// Reorder an attribute array of the given number of components per vertex by triangle
+static void permute(vector<float> &data, const vector<uint32_t> &order, size_t components)
+{
+	if (data.empty())
+	{
+		return;
+	}
+
+	const size_t stride = components * 3;
+	vector<float> sorted(data.size());
+	for (size_t i=0; i<order.size(); i++)
+	{
+		copy(&data[order[i] * stride], &data[order[i] * stride] + stride, &sorted[i * stride]);
+	}
+	data.swap(sorted);
+}
+
+void Meshlets::build(vector<float> &vertices, vector<float> &tex_coords, vector<float> &normals, bool reorder)
+{
+	const size_t num_triangles = vertices.size() / 9;
+
+	// Sort triangles along a Morton curve through their centroids so nearby triangles end up together
+	if (reorder)
+	{
+		float lo[3] = { numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max() };
+		float hi[3] = { -numeric_limits<float>::max(), -numeric_limits<float>::max(), -numeric_limits<float>::max() };
+		for (size_t i=0; i<vertices.size(); i+=3)
+		{
+			for (int k=0; k<3; k++)
+			{
+				lo[k] = min(lo[k], vertices[i+k]);
+				hi[k] = max(hi[k], vertices[i+k]);
+			}
+		}
+
+		vector<pair<uint32_t, uint32_t> > codes(num_triangles);
+		for (size_t t=0; t<num_triangles; t++)
+		{
+			const float *v = &vertices[t * 9];
+			uint32_t code = 0;
+			for (int k=0; k<3; k++)
+			{
+				float centroid = (v[k] + v[k+3] + v[k+6]) / 3.0f;
+				float extent = hi[k] - lo[k];
+				uint32_t q = (extent > 0.0f) ? static_cast<uint32_t>((centroid - lo[k]) / extent * 1023.0f) : 0;
+				code |= spread_bits(q) << k;
+			}
+			codes[t] = make_pair(code, static_cast<uint32_t>(t));
+		}
+		sort(codes.begin(), codes.end());
+
+		vector<uint32_t> order(num_triangles);
+		for (size_t t=0; t<num_triangles; t++)
+		{
+			order[t] = codes[t].second;
+		}
+		permute(vertices, order, 3);
+		permute(tex_coords, order, 2);
+		permute(normals, order, 3);
+	}
+
+	// Split into meshlets, also starting a new one when the normals spread too far to cull
+	m_first.clear();
+	m_count.clear();
+	m_center_x.clear(); m_center_y.clear(); m_center_z.clear(); m_radius.clear();
+	m_axis_x.clear(); m_axis_y.clear(); m_axis_z.clear(); m_cutoff.clear();
+
+	const size_t min_triangles = 16;
+	const float max_spread = 0.5f; // cos(60 degrees)
+	size_t start = 0;
+	float sum[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t t=0; t<num_triangles; t++)
+	{
+		float n[3];
+		face_normal(&vertices[t * 9], n);
+
+		size_t size = t - start;
+		float length = sqrtf(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+		bool spread = (size >= min_triangles && length > 0.0f &&
+					   (n[0] * sum[0] + n[1] * sum[1] + n[2] * sum[2]) < max_spread * length);
+		if (size == max_triangles || spread)
+		{
+			add_bounds(vertices, start * 3, size * 3);
+			start = t;
+			sum[0] = sum[1] = sum[2] = 0.0f;
+		}
+
+		sum[0] += n[0];
+		sum[1] += n[1];
+		sum[2] += n[2];
+	}
+	if (start < num_triangles)
+	{
+		add_bounds(vertices, start * 3, (num_triangles - start) * 3);
+	}
+
+	// Pad to a multiple of four with meshlets that can never be visible
+	while (m_center_x.size() % 4)
+	{
+		m_center_x.push_back(0.0f);
+		m_center_y.push_back(0.0f);
+		m_center_z.push_back(0.0f);
+		m_radius.push_back(-numeric_limits<float>::max());
+		m_axis_x.push_back(0.0f);
+		m_axis_y.push_back(0.0f);
+		m_axis_z.push_back(0.0f);
+		m_cutoff.push_back(1.0f);
+	}
+}
+
+void Meshlets::add_bounds(const vector<float> &vertices, size_t first, size_t count)
+{
+	m_first.push_back(static_cast<int>(first));
+	m_count.push_back(static_cast<int>(count));
+
+	// Sphere around the centre of the bounding box
+	float lo[3] = { numeric_limits<float>::max(), numeric_limits<float>::max(), numeric_limits<float>::max() };
+	float hi[3] = { -numeric_limits<float>::max(), -numeric_limits<float>::max(), -numeric_limits<float>::max() };
+	for (size_t i=first*3; i<(first+count)*3; i+=3)
+	{
+		for (int k=0; k<3; k++)
+		{
+			lo[k] = min(lo[k], vertices[i+k]);
+			hi[k] = max(hi[k], vertices[i+k]);
+		}
+	}
+
+	float center[3] = { (lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, (lo[2] + hi[2]) * 0.5f };
+	float radius2 = 0.0f;
+	for (size_t i=first*3; i<(first+count)*3; i+=3)
+	{
+		float dx = vertices[i+0] - center[0];
+		float dy = vertices[i+1] - center[1];
+		float dz = vertices[i+2] - center[2];
+		radius2 = max(radius2, dx * dx + dy * dy + dz * dz);
+	}
+
+	m_center_x.push_back(center[0]);
+	m_center_y.push_back(center[1]);
+	m_center_z.push_back(center[2]);
+	m_radius.push_back(sqrtf(radius2));
+
+	// The cone axis is the average normal. The cutoff is the sine of the widest angle between it and a face normal.
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t i=first*3; i<(first+count)*3; i+=9)
+	{
+		float n[3];
+		face_normal(&vertices[i], n);
+		axis[0] += n[0];
+		axis[1] += n[1];
+		axis[2] += n[2];
+	}
+	float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	float scale = (length > 0.0f) ? 1.0f / length : 0.0f;
+	axis[0] *= scale;
+	axis[1] *= scale;
+	axis[2] *= scale;
+
+	float min_dot = 1.0f;
+	for (size_t i=first*3; i<(first+count)*3; i+=9)
+	{
+		float n[3];
+		face_normal(&vertices[i], n);
+		if (n[0] != 0.0f || n[1] != 0.0f || n[2] != 0.0f)
+		{
+			min_dot = min(min_dot, n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2]);
+		}
+	}
+
+	m_axis_x.push_back(axis[0]);
+	m_axis_y.push_back(axis[1]);
+	m_axis_z.push_back(axis[2]);
+	m_cutoff.push_back((length > 0.0f && min_dot > 0.0f) ? sqrtf(1.0f - min_dot * min_dot) : 1.0f);
+}
+
+size_t Meshlets::cull(const float *mvp, const float *camera, vector<int> &first, vector<int> &count) const
+{
+	// Frustum planes in model space from the rows of the matrix, normalised so the
+	// distance can be compared against the radius
+	float planes[6][4];
+	for (int p=0; p<6; p++)
+	{
+		int row = p / 2;
+		float sign = (p % 2) ? -1.0f : 1.0f;
+		float length2 = 0.0f;
+		for (int k=0; k<4; k++)
+		{
+			planes[p][k] = mvp[k * 4 + 3] + sign * mvp[k * 4 + row];
+			length2 += (k < 3) ? planes[p][k] * planes[p][k] : 0.0f;
+		}
+		float scale = (length2 > 0.0f) ? 1.0f / sqrtf(length2) : 0.0f;
+		for (int k=0; k<4; k++)
+		{
+			planes[p][k] *= scale;
+		}
+	}
+
+	first.clear();
+	count.clear();
+	size_t triangles = 0;
+	const size_t padded = m_center_x.size();
+
+	// A meshlet is culled if its sphere is outside any plane or if every face points away from the
+	// camera, i.e. dot(centre - camera, axis) >= cutoff * |centre - camera| + radius
+	for (size_t i=0; i<padded; i+=4)
+	{
+		int mask;
+
+#if defined(__SSE__)
+		__m128 cx = _mm_loadu_ps(&m_center_x[i]);
+		__m128 cy = _mm_loadu_ps(&m_center_y[i]);
+		__m128 cz = _mm_loadu_ps(&m_center_z[i]);
+		__m128 r = _mm_loadu_ps(&m_radius[i]);
+		__m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+
+		__m128 visible = _mm_cmpeq_ps(r, r);
+		for (int p=0; p<6; p++)
+		{
+			__m128 d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(planes[p][0])), _mm_mul_ps(cy, _mm_set1_ps(planes[p][1]))),
+				_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(planes[p][2])), _mm_set1_ps(planes[p][3])));
+			visible = _mm_and_ps(visible, _mm_cmpgt_ps(d, neg_r));
+		}
+
+		__m128 dx = _mm_sub_ps(cx, _mm_set1_ps(camera[0]));
+		__m128 dy = _mm_sub_ps(cy, _mm_set1_ps(camera[1]));
+		__m128 dz = _mm_sub_ps(cz, _mm_set1_ps(camera[2]));
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		__m128 dp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(&m_axis_x[i])), _mm_mul_ps(dy, _mm_loadu_ps(&m_axis_y[i]))),
+							   _mm_mul_ps(dz, _mm_loadu_ps(&m_axis_z[i])));
+		__m128 limit = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&m_cutoff[i]), dist), r);
+		visible = _mm_andnot_ps(_mm_cmpge_ps(dp, limit), visible);
+
+		mask = _mm_movemask_ps(visible);
+#else
+		mask = 0;
+		for (int j=0; j<4; j++)
+		{
+			const size_t m = i + j;
+			bool visible = true;
+			for (int p=0; p<6; p++)
+			{
+				float d = planes[p][0] * m_center_x[m] + planes[p][1] * m_center_y[m] + planes[p][2] * m_center_z[m] + planes[p][3];
+				visible = visible && d > -m_radius[m];
+			}
+
+			float dx = m_center_x[m] - camera[0];
+			float dy = m_center_y[m] - camera[1];
+			float dz = m_center_z[m] - camera[2];
+			float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+			float dp = dx * m_axis_x[m] + dy * m_axis_y[m] + dz * m_axis_z[m];
+			visible = visible && !(dp >= m_cutoff[m] * dist + m_radius[m]);
+
+			mask |= visible ? (1 << j) : 0;
+		}
+#endif
+
+		for (int j=0; j<4; j++)
+		{
+			if ((mask & (1 << j)) && i + j < m_first.size())
+			{
+				// Merge with the previous range when contiguous to keep the draw list short
+				const size_t m = i + j;
+				if (!first.empty() && first.back() + count.back() == m_first[m])
+				{
+					count.back() += m_count[m];
+				}
+				else
+				{
+					first.push_back(m_first[m]);
+					count.push_back(m_count[m]);
+				}
+				triangles += m_count[m] / 3;
+			}
+		}
+	}
+
+	return triangles;
+}
@@ -0,0 +1,47 @@
+#ifndef __MESHLET_HPP__
+#define __MESHLET_HPP__
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Clusters of up to max_triangles neighbouring triangles with a bounding sphere and a
+ * cone bounding their face normals, used to cull the mesh on the CPU before drawing.
+ *
+ * Meshlets refer to contiguous ranges of the expanded (three vertices per triangle)
+ * attribute arrays, so build() normally reorders those arrays to keep each cluster together.
+ * Bounds are stored as structure of arrays, padded to a multiple of four, so the cull
+ * pass can test four meshlets at a time.
+ */
+class Meshlets
+{
+public:
+	static const size_t max_triangles = 124;
+
+	/// Sort triangles spatially, reorder the attribute arrays to match and build the meshlets.
+	/// Without reorder the arrays are left in their order, which makes looser meshlets.
+	/// Any of tex_coords and normals may be empty.
+	void build(std::vector<float> &vertices, std::vector<float> &tex_coords, std::vector<float> &normals, bool reorder = true);
+
+	size_t size() const { return m_first.size(); }
+
+	/// Find the meshlets that may be visible. mvp is a column major model-view-projection matrix and
+	/// camera is the camera position in model space. The visible ranges are written to first and count,
+	/// ready for glMultiDrawArrays. Returns the number of triangles in the visible meshlets.
+	size_t cull(const float *mvp, const float *camera, std::vector<int> &first, std::vector<int> &count) const;
+
+private:
+	void add_bounds(const std::vector<float> &vertices, size_t first, size_t count);
+
+	/// Instance variables
+	std::vector<int> m_first;
+	std::vector<int> m_count;
+
+	// Bounding spheres
+	std::vector<float> m_center_x, m_center_y, m_center_z, m_radius;
+
+	// Normal cones. A cutoff of 1 means the cone is too wide to ever cull.
+	std::vector<float> m_axis_x, m_axis_y, m_axis_z, m_cutoff;
+};
+
+#endif // __MESHLET_HPP__
@@ -1,6 +1,5 @@
 #include <cstdlib>
 #include <iostream>
-#include <cstring>
 
 extern "C"
 {
@@ -20,12 +19,27 @@ void Options::initialize(int argc, char *argv[])
 		{"width", required_argument, 0, 'w'},
 		{"height", required_argument, 0, 'h'},
 		{"image", required_argument, 0, 'i'},
+		{"shader-cache", required_argument, 0, 's'},
+		{"no-shader-cache", no_argument, 0, 'S'},
+		{"no-specular", no_argument, 0, 'p'},
+		{"attenuation", no_argument, 0, 'a'},
+		{"capture", required_argument, 0, 'c'},
+		{"watch", no_argument, 0, 'W'},
+		{"no-cull", no_argument, 0, 'C'},
+		{"lights", required_argument, 0, 'l'},
+		{"out-of-core", required_argument, 0, 'o'},
+		{"ram-budget", required_argument, 0, 'r'},
+		{"vram-budget", required_argument, 0, 'g'},
+		{"batch", required_argument, 0, 'b'},
+		{"batch-output", required_argument, 0, 'O'},
+		{"thumbnail-size", required_argument, 0, 'z'},
+		{"jobs", required_argument, 0, 'j'},
+		{"contexts", required_argument, 0, 'x'},
+		{"memory-budget", required_argument, 0, 'm'},
+		{"keep-mesh-data", no_argument, 0, 'k'},
 		{0, 0, 0, 0}
 	};
 
-	strcpy(m_filepath, "");
-	strcpy(m_imagepath, "res/texture.png");
-
 	while (true)
 	{
 		int option_index = 0;
@@ -51,15 +65,70 @@ void Options::initialize(int argc, char *argv[])
 			m_height = atoi(optarg);
 			break;
 		case 'f':
-			strcpy(m_filepath, optarg);
+			m_filepath = optarg;
 			break;
 		case 'i':
-			strcpy(m_imagepath, optarg);
+			m_imagepath = optarg;
+			break;
+		case 's':
+			m_shadercache = optarg;
+			break;
+		case 'S':
+			m_shadercache.clear();
+			break;
+		case 'p':
+			m_specular = false;
+			break;
+		case 'a':
+			m_attenuation = true;
+			break;
+		case 'c':
+			m_capturedir = optarg;
+			break;
+		case 'W':
+			m_watch = true;
+			break;
+		case 'C':
+			m_cull = false;
+			break;
+		case 'l':
+			m_lights = atoi(optarg);
+			break;
+		case 'o':
+			m_chunkdir = optarg;
+			break;
+		case 'r':
+			m_rambudget = atoi(optarg);
+			break;
+		case 'g':
+			m_vrambudget = atoi(optarg);
+			break;
+		case 'b':
+			m_batch = optarg;
+			break;
+		case 'O':
+			m_batchoutput = optarg;
+			break;
+		case 'z':
+			m_thumbnailsize = atoi(optarg);
+			break;
+		case 'j':
+			m_jobs = atoi(optarg);
+			break;
+		case 'x':
+			m_contexts = atoi(optarg);
+			break;
+		case 'm':
+			m_memorybudget = optarg;
+			break;
+		case 'k':
+			m_keepmeshdata = true;
 			break;
 		}
 	}
 
-	if (strlen(m_filepath) == 0)
+	// Batch mode reads its models from the directory or manifest instead
+	if (m_filepath.empty() && m_batch.empty())
 	{
 		cerr << "ERROR: No Wavefront Obj file specified. Aborting.\n";
 		display_help(argv[0]);
@@ -75,4 +144,22 @@ void Options::display_help(const char *app_name)
 	cout << "  --width <width> - width of display in pixels.\n";
 	cout << "  --height <height> - height of display in pixels.\n";
 	cout << "  --image <png file> - PNG of texture to use.\n";
+	cout << "  --shader-cache <dir> - directory to cache linked shader programs in (default .shader_cache).\n";
+	cout << "  --no-shader-cache - always compile shaders from source.\n";
+	cout << "  --no-specular - disable the specular highlight.\n";
+	cout << "  --attenuation - attenuate the light with distance.\n";
+	cout << "  --capture <dir> - write every rendered frame to a PNG in the directory.\n";
+	cout << "  --watch - reload the model and texture when they change on disk.\n";
+	cout << "  --no-cull - start with meshlet culling disabled (toggle with C).\n";
+	cout << "  --lights <count> - light the object with many moving point lights using tiled shading (toggle with L).\n";
+	cout << "  --out-of-core <dir> - stream the model from chunks built in the directory instead of loading it all.\n";
+	cout << "  --ram-budget <MB> - memory for streamed chunks waiting to be drawn (default 1024).\n";
+	cout << "  --vram-budget <MB> - GPU memory for streamed chunks (default 512).\n";
+	cout << "  --batch <dir or manifest> - render a thumbnail of every model instead of opening the viewer.\n";
+	cout << "  --batch-output <dir> - directory to write thumbnails to (default thumbnails).\n";
+	cout << "  --thumbnail-size <pixels> - width and height of the thumbnails (default 256).\n";
+	cout << "  --jobs <count> - threads loading models in batch mode (default one per core).\n";
+	cout << "  --contexts <count> - GL contexts rendering in batch mode (default 1).\n";
+	cout << "  --memory-budget <name=MB,...> - limit memory for mesh-cpu, mesh-gpu, texture-cpu, texture-gpu, shaders or scratch.\n";
+	cout << "  --keep-mesh-data - keep the model in memory after uploading it to the GPU.\n";
 }
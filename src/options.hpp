@@ -1,6 +1,8 @@
 #ifndef __OPTIONS_HPP__
 #define __OPTIONS_HPP__
 
+#include <string>
+
 class Options
 {
 public:
@@ -8,20 +10,54 @@ public:
 	~Options() {}
 
 	bool verbose() const { return m_verbose; }
+	bool specular() const { return m_specular; }
+	bool attenuation() const { return m_attenuation; }
+	bool watch() const { return m_watch; }
+	bool cull() const { return m_cull; }
+	bool keepmeshdata() const { return m_keepmeshdata; }
+	int lights() const { return m_lights; }
+	int rambudget() const { return m_rambudget; }
+	int vrambudget() const { return m_vrambudget; }
+	int thumbnailsize() const { return m_thumbnailsize; }
+	int jobs() const { return m_jobs; }
+	int contexts() const { return m_contexts; }
 	int width() const { return m_width; }
 	int height() const { return m_height; }
-	char *filepath() const { return const_cast<char*>(&m_filepath[0]); }
-	char *imagepath() const { return const_cast<char*>(&m_imagepath[0]); }
+	const char *filepath() const { return m_filepath.c_str(); }
+	const char *imagepath() const { return m_imagepath.c_str(); }
+	const char *shadercache() const { return m_shadercache.c_str(); }
+	const char *capturedir() const { return m_capturedir.c_str(); }
+	const char *chunkdir() const { return m_chunkdir.c_str(); }
+	const char *batch() const { return m_batch.c_str(); }
+	const char *batchoutput() const { return m_batchoutput.c_str(); }
+	const char *memorybudget() const { return m_memorybudget.c_str(); }
 
 private:
 	void initialize(int argc, char *argv[]);
 	void display_help(const char *app_name);
 
 	bool m_verbose = false;
+	bool m_specular = true;
+	bool m_attenuation = false;
+	bool m_watch = false;
+	bool m_cull = true;
+	bool m_keepmeshdata = false;
+	int m_lights = 0;
+	int m_rambudget = 1024;
+	int m_vrambudget = 512;
+	int m_thumbnailsize = 256;
+	int m_jobs = 0;
+	int m_contexts = 1;
 	int m_width = 1024;
 	int m_height = 768;
-	char m_filepath[255];
-	char m_imagepath[255];
+	std::string m_filepath;
+	std::string m_imagepath = "res/texture.png";
+	std::string m_shadercache = ".shader_cache";
+	std::string m_capturedir;
+	std::string m_chunkdir;
+	std::string m_batch;
+	std::string m_batchoutput = "thumbnails";
+	std::string m_memorybudget;
 };
 
 #endif // __OPTIONS_HPP__
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+extern "C"
+{
+// Includes for PNG
+#include <png.h>
+#include <zlib.h>
+}
+
+#include "png_image.hpp"
+
+using namespace std;
+
+bool decode_png(const char *imagepath, PngImage &image, bool verbose)
+{
+	const int header_size = 8;
+	unsigned char header[header_size];
+
+	// Open the file and check it has a PNG signature
+	FILE *file = fopen(imagepath, "rb");
+	if (!file)
+	{
+		cerr << "Image could not be opened: " << imagepath << endl;
+		return false;
+	}
+
+	if (fread(header, 1, header_size, file) != header_size)
+	{
+		cerr << "Failed to read PNG header bytes\n";
+		fclose(file);
+		return false;
+	}
+	
+	if (png_sig_cmp(header, 0, header_size))
+	{
+		cerr << "File is not a valid PNG: " << imagepath << endl;
+		fclose(file);
+		return false;
+	}
+
+	// Create data structures for reading
+    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png_ptr)
+	{
+		cerr << "Failed to create libPNG header struct\n";
+		fclose(file);
+		return false;
+	}
+
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if (!info_ptr)
+    {
+		png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+		cerr << "Failed to create libPNG info struct\n";
+		fclose(file);
+		return false;
+    }
+
+	// libPNG reports errors by jumping back here. Anything needing clean up must be declared above.
+	vector<png_bytep> row_pointers;
+	if (setjmp(png_jmpbuf(png_ptr)))
+	{
+		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+		fclose(file);
+		cerr << "Failed to decode PNG: " << imagepath << endl;
+		return false;
+	}
+
+	png_init_io(png_ptr, file);
+	png_set_sig_bytes(png_ptr, header_size);
+
+	// Read PNG info
+	png_read_info(png_ptr, info_ptr);
+
+	int width      = png_get_image_width(png_ptr, info_ptr);
+	int height     = png_get_image_height(png_ptr, info_ptr);
+	auto color_type = png_get_color_type(png_ptr, info_ptr);
+	auto bit_depth  = png_get_bit_depth(png_ptr, info_ptr);	
+
+	if (verbose)
+	{
+		cout << "PNG texture to be loaded: " << imagepath << endl;
+		cout << "PNG Width: " << width << endl;
+		cout << "PNG Height: " << height << endl;
+		cout << "PNG Color type: " << static_cast<int>(color_type) << endl;
+		cout << "PNG Bit depth: " << static_cast<int>(bit_depth) << endl;
+	}
+
+	// Convert any color type to 8-bit RGBA
+	if (bit_depth == 16)
+	{
+		png_set_strip_16(png_ptr);
+	}
+
+	if (color_type == PNG_COLOR_TYPE_PALETTE)
+	{
+		png_set_palette_to_rgb(png_ptr);
+	}
+
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+	{
+		png_set_expand_gray_1_2_4_to_8(png_ptr);
+	}
+
+	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+	{
+		png_set_tRNS_to_alpha(png_ptr);
+	}
+
+	if (color_type == PNG_COLOR_TYPE_RGB ||
+		color_type == PNG_COLOR_TYPE_GRAY ||
+		color_type == PNG_COLOR_TYPE_PALETTE)
+	{
+		png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+	}
+
+	if (color_type == PNG_COLOR_TYPE_GRAY ||
+		color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+	{
+		png_set_gray_to_rgb(png_ptr);
+	}
+
+	png_read_update_info(png_ptr, info_ptr);
+
+	// Now read data
+	size_t row_size = png_get_rowbytes(png_ptr, info_ptr);
+	image.width = width;
+	image.height = height;
+	vector<unsigned char>().swap(image.data);
+	if (!image.usage.try_set(row_size * height))
+	{
+		image.usage.set(0);
+		if (verbose)
+		{
+			cerr << "Decoding " << imagepath << " would exceed the texture-cpu memory budget\n";
+		}
+		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+		fclose(file);
+		return false;
+	}
+
+	image.data.resize(row_size * height);
+	png_byte *data = image.data.data();
+	row_pointers.resize(height);
+	for (int i=0; i<height; i++)
+	{
+		// Need to flip date over vertically as glTexImage2D expected data origin
+		// to be from the bottom left
+		row_pointers[height - i - 1] = &data[i * row_size];
+	}
+
+	png_read_image(png_ptr, row_pointers.data());
+
+	// Clean up
+	png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+	fclose(file);
+
+	return true;
+}
+
+bool encode_png(const char *path, int width, int height, const unsigned char *pixels)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+	{
+		cerr << "Image could not be opened: " << path << endl;
+		return false;
+	}
+
+	// Flip the image as the GL origin is at the bottom left
+	const size_t row_size = static_cast<size_t>(width) * 4;
+	vector<png_bytep> row_pointers(height);
+	for (int i=0; i<height; i++)
+	{
+		row_pointers[height - i - 1] = const_cast<png_bytep>(&pixels[i * row_size]);
+	}
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : nullptr;
+	if (!info_ptr || setjmp(png_jmpbuf(png_ptr)))
+	{
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		fclose(file);
+		cerr << "Failed to encode PNG: " << path << endl;
+		return false;
+	}
+
+	png_init_io(png_ptr, file);
+
+	// Favour encode speed over file size
+	png_set_compression_level(png_ptr, Z_BEST_SPEED);
+	png_set_filter(png_ptr, 0, PNG_FILTER_SUB);
+
+	png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB,
+				 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png_ptr, info_ptr);
+
+	// Readback is RGBA so strip the alpha, which is not meaningful in the framebuffer
+	png_set_filler(png_ptr, 0, PNG_FILLER_AFTER);
+
+	png_write_image(png_ptr, row_pointers.data());
+	png_write_end(png_ptr, nullptr);
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	fclose(file);
+
+	return true;
+}
@@ -0,0 +1,25 @@
+#ifndef __PNG_IMAGE_HPP__
+#define __PNG_IMAGE_HPP__
+
+#include <vector>
+
+#include "memory_tracker.hpp"
+
+/// Decoded 8-bit RGBA image, stored bottom row first as glTexImage2D expects
+struct PngImage
+{
+	int width = 0;
+	int height = 0;
+	std::vector<unsigned char> data;
+	MemoryUsage usage{MEMORY_TEXTURE_CPU};
+};
+
+/// Decode any PNG to 8-bit RGBA. If verbose, prints the image's size and format.
+/// If the pixels would go over the texture-cpu budget, returns false with the width and
+/// height set and no data, and says so only if verbose.
+bool decode_png(const char *imagepath, PngImage &image, bool verbose = true);
+
+/// Write 8-bit RGBA pixels, stored bottom row first as glReadPixels returns them, to an RGB PNG
+bool encode_png(const char *path, int width, int height, const unsigned char *pixels);
+
+#endif // __PNG_IMAGE_HPP__
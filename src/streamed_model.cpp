@@ -0,0 +1,887 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C"
+{
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include "streamed_model.hpp"
+#include "wavefront_obj.hpp"
+#include "utility.hpp"
+
+using namespace std;
+
+static const char chunk_magic[4] = { 'O', 'B', 'J', 'C' };
+static const uint32_t chunk_version = 2;
+
+/// Upload at most this much per frame so a burst of loaded chunks doesn't stall a frame
+static const size_t upload_budget = 16 * 1024 * 1024;
+
+/// Flush the per cell triangle buffers to the spill file once they hold this many floats
+static const size_t spill_floats = 16 * 1024 * 1024;
+
+/// Read only mapping of a file of floats. The OS pages it in and out as needed.
+class MappedFloats
+{
+public:
+	MappedFloats(const string &path)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		struct stat st;
+		if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				m_data = static_cast<const float *>(p);
+				m_bytes = st.st_size;
+			}
+		}
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+
+	~MappedFloats()
+	{
+		if (m_data)
+		{
+			munmap(const_cast<float *>(m_data), m_bytes);
+		}
+	}
+
+	const float *data() const { return m_data; }
+	size_t size() const { return m_bytes / sizeof(float); }
+
+private:
+	const float *m_data = nullptr;
+	size_t m_bytes = 0;
+};
+
+/// Interleave the bits of three 5 bit grid coordinates
+static uint32_t morton_code(uint32_t x, uint32_t y, uint32_t z)
+{
+	uint32_t code = 0;
+	for (int bit=0; bit<5; bit++)
+	{
+		code |= ((x >> bit) & 1) << (bit * 3);
+		code |= ((y >> bit) & 1) << (bit * 3 + 1);
+		code |= ((z >> bit) & 1) << (bit * 3 + 2);
+	}
+	return code;
+}
+
+/// Hash of the OBJ file's absolute path, or of the path as given if it can't be resolved
+static uint64_t path_hash(const char *obj_path)
+{
+	char *absolute = realpath(obj_path, nullptr);
+	uint64_t hash = hash_fnv1a(absolute ? absolute : obj_path);
+	free(absolute);
+	return hash;
+}
+
+string StreamedModel::chunk_path(const char *chunk_dir, const char *obj_path)
+{
+	string name = obj_path;
+	name = name.substr(name.find_last_of('/') + 1);
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%016llx.chunks", static_cast<unsigned long long>(path_hash(obj_path)));
+	return string(chunk_dir) + "/" + name + suffix;
+}
+
+bool StreamedModel::up_to_date(const char *obj_path, const char *chunk_path)
+{
+	struct stat st;
+	if (stat(obj_path, &st) != 0)
+	{
+		return false;
+	}
+
+	ChunkFileHeader header;
+	ifstream file(chunk_path, ifstream::binary);
+	if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)))
+	{
+		return false;
+	}
+
+	return memcmp(header.magic, chunk_magic, sizeof(chunk_magic)) == 0 && header.version == chunk_version &&
+		header.source_size == static_cast<uint64_t>(st.st_size) && header.source_mtime == static_cast<int64_t>(st.st_mtime) &&
+		header.source_path_hash == path_hash(obj_path);
+}
+
+bool StreamedModel::build(const char *obj_path, const char *chunk_path)
+{
+	auto tp1 = chrono::steady_clock::now();
+
+	struct stat st;
+	if (stat(obj_path, &st) != 0)
+	{
+		cerr << "Unable to open " << obj_path << "\n";
+		return false;
+	}
+
+	ChunkFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, chunk_magic, sizeof(chunk_magic));
+	header.version = chunk_version;
+	header.source_size = st.st_size;
+	header.source_mtime = st.st_mtime;
+	header.source_path_hash = path_hash(obj_path);
+	for (int k=0; k<3; k++)
+	{
+		header.min[k] = numeric_limits<float>::max();
+		header.max[k] = -numeric_limits<float>::max();
+	}
+
+	// Pass 1: copy the attributes to temporary files so they can be looked up by index
+	// without holding them in memory
+	const string tmp_path = string(chunk_path) + ".tmp";
+	const string attribute_paths[3] = { tmp_path + ".v", tmp_path + ".vt", tmp_path + ".vn" };
+	size_t num_attributes[3] = { 0, 0, 0 };
+	size_t num_faces = 0;
+	{
+		ifstream file(obj_path, ifstream::in);
+		ofstream attributes[3];
+		for (int a=0; a<3; a++)
+		{
+			attributes[a].open(attribute_paths[a], ofstream::binary);
+		}
+
+		string line;
+		while (getline(file, line))
+		{
+			istringstream in(line);
+			string type;
+			in >> type;
+
+			float value[3] = { 0.0f, 0.0f, 0.0f };
+			if (type == "v")
+			{
+				in >> value[0] >> value[1] >> value[2];
+				attributes[0].write(reinterpret_cast<const char *>(value), 3 * sizeof(float));
+				num_attributes[0]++;
+				for (int k=0; k<3; k++)
+				{
+					header.min[k] = min(header.min[k], value[k]);
+					header.max[k] = max(header.max[k], value[k]);
+				}
+			}
+			else if (type == "vt")
+			{
+				in >> value[0] >> value[1];
+				attributes[1].write(reinterpret_cast<const char *>(value), 2 * sizeof(float));
+				num_attributes[1]++;
+			}
+			else if (type == "vn")
+			{
+				in >> value[0] >> value[1] >> value[2];
+				attributes[2].write(reinterpret_cast<const char *>(value), 3 * sizeof(float));
+				num_attributes[2]++;
+			}
+			else if (type == "f")
+			{
+				num_faces++;
+			}
+		}
+	}
+
+	MappedFloats positions(attribute_paths[0]);
+	MappedFloats tex_coords(attribute_paths[1]);
+	MappedFloats normals(attribute_paths[2]);
+
+	header.has_tex_coords = num_attributes[1] > 0;
+	header.has_normals = num_attributes[2] > 0;
+	header.stride = 3 + (header.has_tex_coords ? 2 : 0) + (header.has_normals ? 3 : 0);
+	const size_t triangle_floats = 3 * header.stride;
+
+	// Grid with about one chunk of triangles per cell, at most 32 cells a side
+	size_t wanted_cells = max<size_t>(1, num_faces / chunk_triangles);
+	int grid = min(32, max(1, static_cast<int>(ceil(cbrt(static_cast<double>(wanted_cells))))));
+	float cell_size[3];
+	for (int k=0; k<3; k++)
+	{
+		cell_size[k] = (header.max[k] > header.min[k]) ? (header.max[k] - header.min[k]) / grid : 1.0f;
+	}
+
+	// Pass 2: expand the triangles and sort them into grid cells. Cells are buffered in
+	// memory and flushed to a spill file as runs whenever the buffers get too large.
+	const size_t num_cells = static_cast<size_t>(grid) * grid * grid;
+	vector<vector<float> > cell_data(num_cells);
+	vector<vector<pair<uint64_t, uint64_t> > > cell_runs(num_cells);
+	vector<uint64_t> cell_triangles(num_cells, 0);
+	size_t buffered = 0;
+	size_t skipped = 0;
+
+	ofstream spill(tmp_path + ".spill", ofstream::binary);
+	uint64_t spill_offset = 0;
+	auto flush_cells = [&]()
+	{
+		for (size_t c=0; c<num_cells; c++)
+		{
+			if (!cell_data[c].empty())
+			{
+				size_t bytes = cell_data[c].size() * sizeof(float);
+				spill.write(reinterpret_cast<const char *>(cell_data[c].data()), bytes);
+				cell_runs[c].push_back(make_pair(spill_offset, cell_data[c].size()));
+				spill_offset += bytes;
+				vector<float>().swap(cell_data[c]);
+			}
+		}
+		buffered = 0;
+	};
+
+	{
+		ifstream file(obj_path, ifstream::in);
+		string line;
+		vector<unsigned> f, ft, fn;
+		float triangle[3 * 8];
+
+		while (getline(file, line))
+		{
+			if (line.size() < 2 || line[0] != 'f' || line[1] != ' ')
+			{
+				continue;
+			}
+
+			istringstream in(line);
+			string type;
+			in >> type;
+			f.clear();
+			ft.clear();
+			fn.clear();
+			WavefrontObj::parse_face(in, f, ft, fn);
+
+			// Same checks as WavefrontObj::generate_data()
+			bool valid = f.size() >= 3;
+			for (size_t i=0; i<f.size(); i++)
+			{
+				valid = valid && f[i] >= 1 && f[i] <= num_attributes[0];
+			}
+			for (size_t i=0; i<ft.size(); i++)
+			{
+				valid = valid && ft[i] >= 1 && ft[i] <= num_attributes[1];
+			}
+			for (size_t i=0; i<fn.size(); i++)
+			{
+				valid = valid && fn[i] >= 1 && fn[i] <= num_attributes[2];
+			}
+			if (!valid)
+			{
+				skipped++;
+				continue;
+			}
+
+			// Interleave the attributes. Faces missing an attribute the file has get zeros.
+			float centroid[3] = { 0.0f, 0.0f, 0.0f };
+			for (int i=0; i<3; i++)
+			{
+				float *vertex = &triangle[i * header.stride];
+				const float *p = positions.data() + (f[i] - 1) * 3;
+				copy(p, p + 3, vertex);
+				for (int k=0; k<3; k++)
+				{
+					centroid[k] += p[k] / 3.0f;
+				}
+
+				float *next = vertex + 3;
+				if (header.has_tex_coords)
+				{
+					const float *t = (ft.size() >= 3) ? tex_coords.data() + (ft[i] - 1) * 2 : nullptr;
+					next[0] = t ? t[0] : 0.0f;
+					next[1] = t ? t[1] : 0.0f;
+					next += 2;
+				}
+				if (header.has_normals)
+				{
+					const float *n = (fn.size() >= 3) ? normals.data() + (fn[i] - 1) * 3 : nullptr;
+					next[0] = n ? n[0] : 0.0f;
+					next[1] = n ? n[1] : 0.0f;
+					next[2] = n ? n[2] : 0.0f;
+				}
+			}
+
+			int cell[3];
+			for (int k=0; k<3; k++)
+			{
+				cell[k] = min(grid - 1, max(0, static_cast<int>((centroid[k] - header.min[k]) / cell_size[k])));
+			}
+			size_t c = (static_cast<size_t>(cell[2]) * grid + cell[1]) * grid + cell[0];
+			cell_data[c].insert(cell_data[c].end(), triangle, triangle + triangle_floats);
+			cell_triangles[c]++;
+			header.num_triangles++;
+
+			buffered += triangle_floats;
+			if (buffered >= spill_floats)
+			{
+				flush_cells();
+			}
+		}
+	}
+	flush_cells();
+	spill.close();
+
+	for (int a=0; a<3; a++)
+	{
+		remove(attribute_paths[a].c_str());
+	}
+
+	if (skipped)
+	{
+		cerr << obj_path << ": skipped " << skipped << " faces with indices out of range\n";
+	}
+
+	// Pass 3: write the cells in Morton order, split into chunks. The number of chunks is
+	// known up front so the table can go before the data.
+	vector<uint32_t> order(num_cells);
+	for (size_t c=0; c<num_cells; c++)
+	{
+		order[c] = c;
+	}
+	sort(order.begin(), order.end(), [grid](uint32_t a, uint32_t b) {
+		return morton_code(a % grid, (a / grid) % grid, a / (grid * grid)) < morton_code(b % grid, (b / grid) % grid, b / (grid * grid));
+	});
+
+	for (size_t c=0; c<num_cells; c++)
+	{
+		header.num_chunks += (cell_triangles[c] + chunk_triangles - 1) / chunk_triangles;
+	}
+
+	vector<ChunkInfo> chunks;
+	chunks.reserve(header.num_chunks);
+	uint64_t data_offset = sizeof(header) + header.num_chunks * sizeof(ChunkInfo);
+
+	ofstream out(tmp_path, ofstream::binary);
+	ifstream spill_in(tmp_path + ".spill", ifstream::binary);
+	out.seekp(data_offset);
+
+	vector<float> chunk;
+	chunk.reserve(chunk_triangles * triangle_floats);
+	auto emit_chunk = [&]()
+	{
+		if (chunk.empty())
+		{
+			return;
+		}
+
+		ChunkInfo info;
+		memset(&info, 0, sizeof(info));
+		for (int k=0; k<3; k++)
+		{
+			info.min[k] = numeric_limits<float>::max();
+			info.max[k] = -numeric_limits<float>::max();
+		}
+		for (size_t i=0; i<chunk.size(); i+=header.stride)
+		{
+			for (int k=0; k<3; k++)
+			{
+				info.min[k] = min(info.min[k], chunk[i + k]);
+				info.max[k] = max(info.max[k], chunk[i + k]);
+			}
+		}
+		info.offset = data_offset;
+		info.triangles = chunk.size() / triangle_floats;
+		chunks.push_back(info);
+
+		out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size() * sizeof(float));
+		data_offset += chunk.size() * sizeof(float);
+		chunk.clear();
+	};
+
+	for (uint32_t c : order)
+	{
+		for (auto &run : cell_runs[c])
+		{
+			spill_in.seekg(run.first);
+			uint64_t remaining = run.second;
+			while (remaining > 0)
+			{
+				size_t space = chunk_triangles * triangle_floats - chunk.size();
+				size_t count = min<uint64_t>(remaining, space);
+				size_t start = chunk.size();
+				chunk.resize(start + count);
+				spill_in.read(reinterpret_cast<char *>(&chunk[start]), count * sizeof(float));
+				remaining -= count;
+
+				if (chunk.size() == chunk_triangles * triangle_floats)
+				{
+					emit_chunk();
+				}
+			}
+		}
+		emit_chunk();
+	}
+
+	out.seekp(0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char *>(chunks.data()), chunks.size() * sizeof(ChunkInfo));
+	bool ok = spill_in.good() && out.good();
+	out.close();
+	spill_in.close();
+	remove((tmp_path + ".spill").c_str());
+
+	if (!ok || rename(tmp_path.c_str(), chunk_path) != 0)
+	{
+		cerr << "Failed to write " << chunk_path << "\n";
+		remove(tmp_path.c_str());
+		return false;
+	}
+
+	chrono::duration<float> elapsed = chrono::steady_clock::now() - tp1;
+	cout << "Built " << chunk_path << ": " << header.num_triangles << " triangles in " << header.num_chunks
+		 << " chunks in " << elapsed.count() << " s\n";
+	return true;
+}
+
+StreamedModel::StreamedModel(const char *chunk_path, size_t ram_budget, size_t vram_budget)
+	: m_chunk_path(chunk_path), m_ram_budget(ram_budget), m_vram_budget(vram_budget)
+{
+	ifstream file(chunk_path, ifstream::binary);
+	if (!file.read(reinterpret_cast<char *>(&m_header), sizeof(m_header)) ||
+		memcmp(m_header.magic, chunk_magic, sizeof(chunk_magic)) != 0 || m_header.version != chunk_version)
+	{
+		cerr << "Unable to read chunk file " << chunk_path << "\n";
+		return;
+	}
+
+	m_chunks.resize(m_header.num_chunks);
+	if (!file.read(reinterpret_cast<char *>(m_chunks.data()), m_chunks.size() * sizeof(ChunkInfo)))
+	{
+		cerr << "Chunk file " << chunk_path << " is truncated\n";
+		m_chunks.clear();
+		return;
+	}
+
+	// Every chunk must fit in each budget on its own
+	size_t largest = 0;
+	for (size_t c=0; c<m_chunks.size(); c++)
+	{
+		largest = max(largest, chunk_bytes(c));
+	}
+	m_ram_budget = max(m_ram_budget, largest);
+	m_vram_budget = max(m_vram_budget, largest);
+
+	build_hierarchy();
+	m_resident.resize(m_chunks.size());
+	m_rate_start = chrono::steady_clock::now();
+	m_thread = thread(&StreamedModel::io_thread, this);
+}
+
+StreamedModel::~StreamedModel()
+{
+	if (m_thread.joinable())
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_one();
+		m_thread.join();
+	}
+
+	for (auto &r : m_resident)
+	{
+		if (r.buffer)
+		{
+			glDeleteBuffers(1, &r.buffer);
+		}
+	}
+}
+
+float StreamedModel::get_scaler() const
+{
+	float x = m_header.max[0] - m_header.min[0];
+	float y = m_header.max[1] - m_header.min[1];
+	float z = m_header.max[2] - m_header.min[2];
+	return sqrtf(x * x + y * y + z * z);
+}
+
+void StreamedModel::build_hierarchy()
+{
+	// Chunks are in Morton order, so grouping runs of eight gives an octree-like hierarchy.
+	// Children of a node are contiguous and the root is the last node.
+	m_nodes.clear();
+	for (size_t c=0; c<m_chunks.size(); c++)
+	{
+		Node node;
+		copy(m_chunks[c].min, m_chunks[c].min + 3, node.min);
+		copy(m_chunks[c].max, m_chunks[c].max + 3, node.max);
+		node.first = c;
+		node.count = 1;
+		node.leaf = true;
+		m_nodes.push_back(node);
+	}
+
+	size_t level_start = 0;
+	size_t level_end = m_nodes.size();
+	while (level_end - level_start > 1)
+	{
+		for (size_t first=level_start; first<level_end; first+=8)
+		{
+			Node node;
+			node.first = first;
+			node.count = min<size_t>(8, level_end - first);
+			node.leaf = false;
+			copy(m_nodes[first].min, m_nodes[first].min + 3, node.min);
+			copy(m_nodes[first].max, m_nodes[first].max + 3, node.max);
+			for (size_t child=first+1; child<first+node.count; child++)
+			{
+				for (int k=0; k<3; k++)
+				{
+					node.min[k] = min(node.min[k], m_nodes[child].min[k]);
+					node.max[k] = max(node.max[k], m_nodes[child].max[k]);
+				}
+			}
+			m_nodes.push_back(node);
+		}
+		level_start = level_end;
+		level_end = m_nodes.size();
+	}
+}
+
+size_t StreamedModel::update(const float *mvp, const float *camera)
+{
+	if (m_nodes.empty())
+	{
+		return 0;
+	}
+
+	// Frustum planes in model space, as Meshlets::cull()
+	float planes[6][4];
+	for (int p=0; p<6; p++)
+	{
+		int row = p / 2;
+		float sign = (p % 2) ? -1.0f : 1.0f;
+		float length2 = 0.0f;
+		for (int k=0; k<4; k++)
+		{
+			planes[p][k] = mvp[k * 4 + 3] + sign * mvp[k * 4 + row];
+			length2 += (k < 3) ? planes[p][k] * planes[p][k] : 0.0f;
+		}
+		float scale = (length2 > 0.0f) ? 1.0f / sqrtf(length2) : 0.0f;
+		for (int k=0; k<4; k++)
+		{
+			planes[p][k] *= scale;
+		}
+	}
+
+	// Walk the hierarchy for the visible chunks. The priority is the bounding sphere's radius
+	// over its distance, which is proportional to its size on screen.
+	m_visible.clear();
+	vector<uint32_t> stack(1, m_nodes.size() - 1);
+	while (!stack.empty())
+	{
+		const Node &node = m_nodes[stack.back()];
+		stack.pop_back();
+
+		float center[3];
+		float radius2 = 0.0f;
+		for (int k=0; k<3; k++)
+		{
+			center[k] = (node.min[k] + node.max[k]) * 0.5f;
+			radius2 += (node.max[k] - center[k]) * (node.max[k] - center[k]);
+		}
+		float radius = sqrtf(radius2);
+
+		bool inside = true;
+		for (int p=0; p<6 && inside; p++)
+		{
+			inside = planes[p][0] * center[0] + planes[p][1] * center[1] + planes[p][2] * center[2] + planes[p][3] >= -radius;
+		}
+		if (!inside)
+		{
+			continue;
+		}
+
+		if (node.leaf)
+		{
+			float dx = center[0] - camera[0];
+			float dy = center[1] - camera[1];
+			float dz = center[2] - camera[2];
+			float distance = max(sqrtf(dx * dx + dy * dy + dz * dz) - radius, radius * 1e-3f);
+			m_visible.push_back(make_pair(radius / distance, node.first));
+		}
+		else
+		{
+			for (uint32_t child=node.first; child<node.first+node.count; child++)
+			{
+				stack.push_back(child);
+			}
+		}
+	}
+	sort(m_visible.begin(), m_visible.end(), greater<pair<float, uint32_t> >());
+
+	// Queue the chunks that aren't in memory, largest on screen first, replacing last frame's
+	// requests. Collect loaded chunks to upload.
+	vector<pair<uint32_t, shared_ptr<const vector<float> > > > uploads;
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_frame++;
+		m_pending.clear();
+		size_t upload_bytes = 0;
+		for (auto &visible : m_visible)
+		{
+			Resident &r = m_resident[visible.second];
+			r.last_used = m_frame;
+			r.priority = visible.first;
+			if (r.buffer)
+			{
+				continue;
+			}
+
+			if (r.data)
+			{
+				if (upload_bytes < upload_budget)
+				{
+					uploads.push_back(make_pair(visible.second, r.data));
+					upload_bytes += chunk_bytes(visible.second);
+				}
+			}
+			else if (!r.loading && !r.failed)
+			{
+				m_pending.push_back(visible.second);
+			}
+		}
+	}
+	m_wake.notify_one();
+
+	for (auto &upload : uploads)
+	{
+		size_t bytes = chunk_bytes(upload.first);
+		if (!make_vram_space(bytes, m_resident[upload.first].priority))
+		{
+			break;
+		}
+
+		GLuint buffer;
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, bytes, upload.second->data(), GL_STATIC_DRAW);
+		m_vram_bytes += bytes;
+		m_vram_chunks++;
+
+		lock_guard<mutex> lock(m_mutex);
+		m_resident[upload.first].buffer = buffer;
+	}
+
+	size_t triangles = 0;
+	m_drawn.clear();
+	for (auto &visible : m_visible)
+	{
+		if (m_resident[visible.second].buffer)
+		{
+			m_drawn.push_back(visible.second);
+			triangles += m_chunks[visible.second].triangles;
+		}
+	}
+
+	// Account the caches once a frame rather than on every load and eviction
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_ram_memory.set(m_ram_bytes);
+	}
+	m_vram_memory.set(m_vram_bytes);
+
+	// I/O bandwidth over the last second
+	auto now = chrono::steady_clock::now();
+	chrono::duration<float> elapsed = now - m_rate_start;
+	if (elapsed.count() >= 1.0f)
+	{
+		size_t bytes_read;
+		{
+			lock_guard<mutex> lock(m_mutex);
+			bytes_read = m_bytes_read;
+		}
+		m_io_rate = (bytes_read - m_rate_bytes) / elapsed.count();
+		m_rate_bytes = bytes_read;
+		m_rate_start = now;
+	}
+
+	return triangles;
+}
+
+void StreamedModel::draw() const
+{
+	const GLsizei stride = m_header.stride * sizeof(float);
+	const size_t normal_offset = (m_header.has_tex_coords ? 5 : 3) * sizeof(float);
+
+	glEnableVertexAttribArray(0);
+	if (has_tex_coords())
+	{
+		glEnableVertexAttribArray(1);
+	}
+	if (has_normals())
+	{
+		glEnableVertexAttribArray(2);
+	}
+
+	for (uint32_t c : m_drawn)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_resident[c].buffer);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		if (has_tex_coords())
+		{
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		}
+		if (has_normals())
+		{
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)normal_offset);
+		}
+		glDrawArrays(GL_TRIANGLES, 0, m_chunks[c].triangles * 3);
+	}
+}
+
+StreamStats StreamedModel::stats() const
+{
+	StreamStats stats;
+	stats.vram_bytes = m_vram_bytes;
+	stats.vram_chunks = m_vram_chunks;
+	stats.io_mb_per_second = m_io_rate / (1024.0f * 1024.0f);
+
+	lock_guard<mutex> lock(m_mutex);
+	stats.ram_bytes = m_ram_bytes;
+	stats.ram_chunks = m_ram_chunks;
+	stats.queue_depth = m_pending.size();
+	stats.bytes_read = m_bytes_read;
+	return stats;
+}
+
+/// Eviction order: chunks not visible this frame, least recently used first, then visible
+/// chunks by priority. Lower is evicted first.
+static pair<uint64_t, float> eviction_score(uint64_t last_used, float priority, uint64_t frame)
+{
+	return (last_used < frame) ? make_pair(last_used, 0.0f) : make_pair(frame, priority);
+}
+
+bool StreamedModel::make_vram_space(size_t bytes, float priority)
+{
+	while (m_vram_bytes + bytes > m_vram_budget)
+	{
+		size_t victim = m_resident.size();
+		pair<uint64_t, float> victim_score;
+		for (size_t c=0; c<m_resident.size(); c++)
+		{
+			const Resident &r = m_resident[c];
+			if (!r.buffer || (r.last_used == m_frame && r.priority >= priority))
+			{
+				continue;
+			}
+
+			auto score = eviction_score(r.last_used, r.priority, m_frame);
+			if (victim == m_resident.size() || score < victim_score)
+			{
+				victim = c;
+				victim_score = score;
+			}
+		}
+		if (victim == m_resident.size())
+		{
+			return false;
+		}
+
+		GLuint buffer = m_resident[victim].buffer;
+		glDeleteBuffers(1, &buffer);
+		m_vram_bytes -= chunk_bytes(victim);
+		m_vram_chunks--;
+
+		lock_guard<mutex> lock(m_mutex);
+		m_resident[victim].buffer = 0;
+	}
+	return true;
+}
+
+bool StreamedModel::make_ram_space(size_t bytes, float priority)
+{
+	while (m_ram_bytes + bytes > m_ram_budget)
+	{
+		// Copies of chunks already in VRAM are only needed if they are evicted from it, so
+		// they go before visible chunks still waiting to be uploaded
+		size_t victim = m_resident.size();
+		pair<uint64_t, float> victim_score;
+		for (size_t c=0; c<m_resident.size(); c++)
+		{
+			const Resident &r = m_resident[c];
+			if (!r.data || (r.last_used == m_frame && !r.buffer && r.priority >= priority))
+			{
+				continue;
+			}
+
+			auto score = eviction_score(r.last_used, r.buffer ? -1.0f : r.priority, m_frame);
+			if (victim == m_resident.size() || score < victim_score)
+			{
+				victim = c;
+				victim_score = score;
+			}
+		}
+		if (victim == m_resident.size())
+		{
+			return false;
+		}
+
+		m_resident[victim].data.reset();
+		m_ram_bytes -= chunk_bytes(victim);
+		m_ram_chunks--;
+	}
+	return true;
+}
+
+void StreamedModel::io_thread()
+{
+	ifstream file(m_chunk_path, ifstream::binary);
+
+	unique_lock<mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wake.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+		if (m_stop)
+		{
+			break;
+		}
+
+		uint32_t c = m_pending.front();
+		m_pending.pop_front();
+
+		Resident &r = m_resident[c];
+		size_t bytes = chunk_bytes(c);
+		if (r.data || r.loading || !make_ram_space(bytes, r.priority))
+		{
+			// If everything in memory is still needed the chunk is asked for again next frame
+			continue;
+		}
+
+		// Reserve the memory, then read without holding the lock
+		r.loading = true;
+		m_ram_bytes += bytes;
+		lock.unlock();
+
+		shared_ptr<vector<float> > data(new vector<float>(bytes / sizeof(float)));
+		file.seekg(m_chunks[c].offset);
+		bool ok = static_cast<bool>(file.read(reinterpret_cast<char *>(data->data()), bytes));
+		file.clear();
+
+		lock.lock();
+		r.loading = false;
+		if (ok)
+		{
+			r.data = data;
+			m_ram_chunks++;
+			m_bytes_read += bytes;
+		}
+		else
+		{
+			cerr << "Failed to read chunk " << c << " from " << m_chunk_path << "\n";
+			r.failed = true;
+			m_ram_bytes -= bytes;
+		}
+	}
+}
@@ -0,0 +1,181 @@
+#ifndef __STREAMED_MODEL_HPP__
+#define __STREAMED_MODEL_HPP__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+extern "C"
+{
+// Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
+#include <GL/glew.h>
+}
+
+#include "memory_tracker.hpp"
+
+/// Header of a chunk file. The chunk table follows it, then the vertex data.
+struct ChunkFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t source_size;
+	int64_t source_mtime;
+	uint64_t source_path_hash; // of the absolute path, so models with the same name differ
+	uint32_t stride;       // floats per vertex
+	uint32_t has_tex_coords;
+	uint32_t has_normals;
+	uint32_t num_chunks;
+	uint64_t num_triangles;
+	float min[3];
+	float max[3];
+};
+
+/// Entry in the chunk table
+struct ChunkInfo
+{
+	float min[3];
+	float max[3];
+	uint64_t offset;       // bytes from the start of the file
+	uint32_t triangles;
+	uint32_t padding;
+};
+
+/// Streaming statistics
+struct StreamStats
+{
+	size_t ram_bytes = 0;
+	size_t vram_bytes = 0;
+	size_t ram_chunks = 0;
+	size_t vram_chunks = 0;
+	size_t queue_depth = 0;
+	float io_mb_per_second = 0.0f;
+	size_t bytes_read = 0;
+};
+
+/**
+ * Model too large to hold in memory, drawn from a chunk file on disk.
+ *
+ * build() converts an OBJ into fixed size chunks of interleaved vertices, grouped by a
+ * spatial grid and written in Morton order so that runs of chunks are close together.
+ * At load only the chunk table is read, and a hierarchy of bounds is built over it.
+ *
+ * Every frame update() finds the visible chunks, orders them by projected size and
+ * hands those not in memory to an I/O thread. Loaded chunks wait in a RAM cache and a
+ * limited amount is uploaded each frame so the viewer stays interactive. Both caches
+ * are held under budgets by evicting the least recently visible chunks.
+ */
+class StreamedModel
+{
+public:
+	static const uint32_t chunk_triangles = 32768;
+
+	/// Constructors. Budgets are in bytes.
+	StreamedModel(const char *chunk_path, size_t ram_budget, size_t vram_budget);
+
+	/// Destructors.
+	~StreamedModel();
+
+	/// Convert an OBJ file into a chunk file, keeping memory use bounded however large the model is.
+	static bool build(const char *obj_path, const char *chunk_path);
+
+	/// True if the chunk file exists and was built from the OBJ file as it is now.
+	static bool up_to_date(const char *obj_path, const char *chunk_path);
+
+	/// Chunk file in chunk_dir for the OBJ file. The name has the OBJ's name and a hash of its
+	/// absolute path, so models with the same name in different directories don't share one.
+	static std::string chunk_path(const char *chunk_dir, const char *obj_path);
+
+	bool valid() const { return !m_chunks.empty(); }
+	bool has_tex_coords() const { return m_header.has_tex_coords != 0; }
+	bool has_normals() const { return m_header.has_normals != 0; }
+	size_t num_triangles() const { return m_header.num_triangles; }
+	size_t num_vertices() const { return m_header.num_triangles * 3; }
+
+	/// Diagonal length of the bounding box, as WavefrontObj::get_scaler().
+	float get_scaler() const;
+
+	/// Request and upload the chunks visible with the column major model-view-projection
+	/// matrix. camera is the camera position in model space. Returns the number of
+	/// triangles that draw() will draw.
+	size_t update(const float *mvp, const float *camera);
+
+	/// Draw the visible chunks that are resident in VRAM. Sets up vertex attributes 0 to 2.
+	void draw() const;
+
+	StreamStats stats() const;
+
+private:
+	struct Node
+	{
+		float min[3];
+		float max[3];
+		uint32_t first;    // first child node, or chunk for leaves
+		uint32_t count;
+		bool leaf;
+	};
+
+	/// Chunk being read or held in the RAM cache
+	struct Resident
+	{
+		std::shared_ptr<const std::vector<float> > data;
+		bool loading = false;
+		bool failed = false;
+		GLuint buffer = 0;
+		uint64_t last_used = 0;
+		float priority = 0.0f;     // when last visible
+	};
+
+	void build_hierarchy();
+	void io_thread();
+
+	/// Evict chunks from RAM until bytes more fit for a chunk of the given priority. Chunks that
+	/// aren't visible go first, least recently used first. Called with m_mutex held.
+	bool make_ram_space(size_t bytes, float priority);
+
+	/// As make_ram_space() for VRAM.
+	bool make_vram_space(size_t bytes, float priority);
+
+	size_t chunk_bytes(size_t chunk) const { return m_chunks[chunk].triangles * 3 * m_header.stride * sizeof(float); }
+
+	/// Instance variables
+	std::string m_chunk_path;
+	ChunkFileHeader m_header;
+	std::vector<ChunkInfo> m_chunks;
+	std::vector<Node> m_nodes;
+	size_t m_ram_budget;
+	size_t m_vram_budget;
+	uint64_t m_frame = 0;
+
+	// Visible chunks this frame, largest on screen first
+	std::vector<std::pair<float, uint32_t> > m_visible;
+	std::vector<uint32_t> m_drawn;
+
+	// Shared with the I/O thread
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::deque<uint32_t> m_pending;
+	std::vector<Resident> m_resident;
+	size_t m_ram_bytes = 0;
+	size_t m_ram_chunks = 0;
+	size_t m_bytes_read = 0;
+	bool m_stop = false;
+	std::thread m_thread;
+
+	// Main thread only
+	size_t m_vram_bytes = 0;
+	size_t m_vram_chunks = 0;
+	std::chrono::steady_clock::time_point m_rate_start;
+	size_t m_rate_bytes = 0;
+	float m_io_rate = 0.0f;
+	MemoryUsage m_ram_memory{MEMORY_MESH_CPU};
+	MemoryUsage m_vram_memory{MEMORY_MESH_GPU};
+};
+
+#endif // __STREAMED_MODEL_HPP__
@@ -2,234 +2,511 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <sstream>
 
 extern "C"
 {
 // Include GLEW. Always include it before gl.h and glfw.h, since it's a bit magic.
 #include <GL/glew.h>
 
-// Includes for PNG
-#include <png.h>
-#include <zlib.h>
+// For creating the program cache directory
+#include <sys/stat.h>
 }
 
+#include "utility.hpp"
+
 using namespace std;
 
-GLuint load_png(const char *imagepath)
+GLuint create_texture(const PngImage &image)
+{
+	GLuint texture_id;
+	glGenTextures(1, &texture_id);
+	update_texture(texture_id, image);
+
+	// Set-up filtering
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	return texture_id;
+}
+
+void update_texture(GLuint texture_id, const PngImage &image)
 {
-	const int header_size = 8;
-	unsigned char header[header_size];
+	glBindTexture(GL_TEXTURE_2D, texture_id);
 
-	// Open the file and check it has a PNG signature
-	FILE *file = fopen(imagepath, "rb");
-	if (!file)
+	// Replace the contents in place if the size is unchanged, otherwise reallocate
+	GLint width = 0;
+	GLint height = 0;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	if (width == image.width && height == image.height)
 	{
-		cerr << "Image could not be opened: " << imagepath << endl;
-		return 0;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.data.data());
 	}
-
-	if (fread(header, 1, header_size, file) != header_size)
+	else
 	{
-		cerr << "Failed to read PNG header bytes\n";
-		return 0;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data.data());
 	}
-	
-	if (png_sig_cmp(header, 0, header_size))
+	glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+GLuint load_png(const char *imagepath)
+{
+	PngImage image;
+	if (!decode_png(imagepath, image))
 	{
-		cerr << "File is not a valid PNG: " << imagepath << endl;
 		return 0;
 	}
 
-	// Create data structures for reading
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-    if (!png_ptr)
+	if (!memory_fits(MEMORY_TEXTURE_GPU, texture_size(image)))
 	{
-		cerr << "Failed to create libPNG header struct\n";
+		cerr << "Uploading " << imagepath << " would exceed the texture-gpu memory budget\n";
 		return 0;
 	}
 
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if (!info_ptr)
-    {
-		png_destroy_read_struct(&png_ptr, nullptr, nullptr);
-		cerr << "Failed to create libPNG info struct\n";
-		return 0;
-    }
+	return create_texture(image);
+}
 
-	png_init_io(png_ptr, file);
-	png_set_sig_bytes(png_ptr, header_size);
+size_t buffer_size(GLuint buffer_id)
+{
+	GLint size = 0;
+	glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+	glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+	return size;
+}
 
-	// Read PNG info
-	png_read_info(png_ptr, info_ptr);
+size_t texture_size(const PngImage &image)
+{
+	// Drivers store RGB textures at four bytes a pixel, as the image is. Mipmaps add a third.
+	return image.data.size() * 4 / 3;
+}
 
-	int width      = png_get_image_width(png_ptr, info_ptr);
-	int height     = png_get_image_height(png_ptr, info_ptr);
-	auto color_type = png_get_color_type(png_ptr, info_ptr);
-	auto bit_depth  = png_get_bit_depth(png_ptr, info_ptr);	
+size_t texture_size(GLuint texture_id)
+{
+	glBindTexture(GL_TEXTURE_2D, texture_id);
 
-	cout << "PNG texture to be loaded: " << imagepath << endl;
-	cout << "PNG Width: " << width << endl;
-	cout << "PNG Height: " << height << endl;
-	cout << "PNG Color type: " << static_cast<int>(color_type) << endl;
-	cout << "PNG Bit depth: " << static_cast<int>(bit_depth) << endl;
+	// Sum over all the mipmap levels using the precision the driver actually chose
+	size_t total = 0;
+	for (GLint level=0; ; level++)
+	{
+		GLint width = 0, height = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if (width == 0 || height == 0)
+		{
+			break;
+		}
+
+		GLint bits = 0;
+		const GLenum components[] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE, GL_TEXTURE_ALPHA_SIZE };
+		for (GLenum component : components)
+		{
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, component, &size);
+			bits += size;
+		}
+		total += static_cast<size_t>(width) * height * bits / 8;
+	}
+	return total;
+}
 
-	// Convert any color type to 8-bit RGBA
-	if (bit_depth == 16)
+/// Read the whole of a file into a string with a single bulk read
+static bool read_file(const char *path, string &contents)
+{
+	ifstream stream(path, ios::in | ios::binary);
+	if (!stream.is_open())
 	{
-		png_set_strip_16(png_ptr);
+		return false;
 	}
 
-	if (color_type == PNG_COLOR_TYPE_PALETTE)
+	stream.seekg(0, ios::end);
+	contents.resize(static_cast<size_t>(stream.tellg()));
+	stream.seekg(0, ios::beg);
+	stream.read(&contents[0], contents.size());
+
+	return stream.good() || stream.eof();
+}
+
+uint64_t hash_fnv1a(const string &data, uint64_t hash)
+{
+	for (unsigned char c : data)
 	{
-		png_set_palette_to_rgb(png_ptr);
+		hash ^= c;
+		hash *= 1099511628211ULL;
 	}
+	return hash;
+}
+
+/// glGetString() as a string, empty if the query failed
+static string gl_string(GLenum name)
+{
+	const GLubyte *value = glGetString(name);
+	return value ? reinterpret_cast<const char*>(value) : "";
+}
 
-	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+static const char *shader_feature_names[] = { "TEXTURED", "LIT", "SPECULAR", "ATTENUATION", "LIGHT_LIST", "TILED" };
+
+/// Build the #define block for a set of shader features
+static string shader_defines(unsigned features)
+{
+	string defines;
+	for (size_t i=0; i<sizeof(shader_feature_names)/sizeof(shader_feature_names[0]); i++)
 	{
-		png_set_expand_gray_1_2_4_to_8(png_ptr);
+		if (features & (1u << i))
+		{
+			defines += string("#define ") + shader_feature_names[i] + "\n";
+		}
 	}
+	return defines;
+}
 
-	if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+/// Insert the defines after the #version directive, which must stay the first line
+static string inject_defines(const string &code, const string &defines)
+{
+	size_t pos = 0;
+	if (code.compare(0, 8, "#version") == 0)
 	{
-		png_set_tRNS_to_alpha(png_ptr);
+		pos = code.find('\n');
+		pos = (pos == string::npos) ? code.size() : pos + 1;
 	}
+	return code.substr(0, pos) + defines + code.substr(pos);
+}
 
-	if (color_type == PNG_COLOR_TYPE_RGB ||
-		color_type == PNG_COLOR_TYPE_GRAY ||
-		color_type == PNG_COLOR_TYPE_PALETTE)
+/// Give a rough static cost of a shader variant by counting the operations left after
+/// the feature #ifdefs have been resolved. Drivers don't expose real instruction counts
+/// portably, but this is enough to compare variants against one another.
+static void report_shader_cost(const char *file_path, const string &code, unsigned features)
+{
+	vector<bool> active(1, true);
+	unsigned alu_ops = 0;
+	unsigned tex_fetches = 0;
+	bool in_main = false;
+
+	istringstream in(code);
+	string line;
+	while (getline(in, line))
 	{
-		png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+		// Strip comments
+		line = line.substr(0, line.find("//"));
+
+		istringstream words(line);
+		string directive, name;
+		words >> directive >> name;
+
+		bool defined = false;
+		for (size_t i=0; i<sizeof(shader_feature_names)/sizeof(shader_feature_names[0]); i++)
+		{
+			if (name == shader_feature_names[i])
+			{
+				defined = (features & (1u << i)) != 0;
+			}
+		}
+
+		if (directive == "#ifdef" || directive == "#ifndef")
+		{
+			active.push_back(active.back() && (defined == (directive == "#ifdef")));
+			continue;
+		}
+		else if (directive == "#else" && active.size() > 1)
+		{
+			bool parent = active[active.size() - 2];
+			active.back() = parent && !active.back();
+			continue;
+		}
+		else if (directive == "#endif" && active.size() > 1)
+		{
+			active.pop_back();
+			continue;
+		}
+
+		if (line.find("void main") != string::npos)
+		{
+			in_main = true;
+		}
+
+		if (!active.back() || !in_main)
+		{
+			continue;
+		}
+
+		size_t i = 0;
+		while (i < line.size())
+		{
+			if (isalpha(line[i]) || line[i] == '_')
+			{
+				size_t end = i;
+				while (end < line.size() && (isalnum(line[end]) || line[end] == '_'))
+				{
+					end++;
+				}
+				string word = line.substr(i, end - i);
+				i = end;
+
+				// Only function calls count, type constructors are free
+				while (end < line.size() && line[end] == ' ')
+				{
+					end++;
+				}
+				if (end == line.size() || line[end] != '(' || word.find("vec") != string::npos || word == "float" || word == "main")
+				{
+					continue;
+				}
+
+				if (word == "texture")
+				{
+					tex_fetches++;
+				}
+				else
+				{
+					alu_ops++;
+				}
+			}
+			else
+			{
+				// Arithmetic operators
+				if (strchr("+-*/", line[i]))
+				{
+					alu_ops++;
+				}
+				i++;
+			}
+		}
 	}
 
-	if (color_type == PNG_COLOR_TYPE_GRAY ||
-		color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+	string names;
+	for (size_t i=0; i<sizeof(shader_feature_names)/sizeof(shader_feature_names[0]); i++)
 	{
-		png_set_gray_to_rgb(png_ptr);
+		if (features & (1u << i))
+		{
+			names += string(names.empty() ? "" : " ") + shader_feature_names[i];
+		}
 	}
 
-	png_read_update_info(png_ptr, info_ptr);
+	cout << "Shader variant [" << names << "] " << file_path << ": ~" << alu_ops << " ALU ops, "
+		 << tex_fetches << " texture fetches\n";
+}
+
+static GLuint compile_shader(GLenum type, const char *file_path, const string &code)
+{
+	cout << "Compiling shader: " << file_path << endl;
+	GLuint shader_id = glCreateShader(type);
+	char const *source_pointer = code.c_str();
+	glShaderSource(shader_id, 1, &source_pointer, NULL);
+	glCompileShader(shader_id);
 
-	// Now read data
-	size_t row_size = png_get_rowbytes(png_ptr, info_ptr);
-	png_byte *data = new png_byte[row_size * height];
-	vector<png_bytep> row_pointers(height);
-	for (int i=0; i<height; i++)
+	// Check Shader
+	GLint result = GL_FALSE;
+	int info_log_length;
+	glGetShaderiv(shader_id, GL_COMPILE_STATUS, &result);
+	glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
+	if ( info_log_length > 0 )
 	{
-		// Need to flip date over vertically as glTexImage2D expected data origin
-		// to be from the bottom left
-		row_pointers[height - i - 1] = &data[i * row_size];
+		vector<char> shader_error_message(info_log_length+1);
+		glGetShaderInfoLog(shader_id, info_log_length, NULL, &shader_error_message[0]);
+		cerr << &shader_error_message[0] << endl;
+	}
+	if (!result)
+	{
+		glDeleteShader(shader_id);
+		return 0;
 	}
 
-	png_read_image(png_ptr, row_pointers.data());
+	return shader_id;
+}
 
-	// Now create GLES texture
-	GLuint texture_id;
-	glGenTextures(1, &texture_id);
-	glBindTexture(GL_TEXTURE_2D, texture_id);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+/// Header written in front of each cached program binary
+struct ProgramCacheHeader
+{
+	char magic[4];
+	GLenum format;
+	uint64_t key;
+	uint64_t compile_us;
+};
 
-	// Set-up filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glGenerateMipmap(GL_TEXTURE_2D);
+static bool program_binary_supported()
+{
+	if (!GLEW_ARB_get_program_binary)
+	{
+		return false;
+	}
 
-	// Clean up
-	delete [] data;
-	png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
-	fclose(file);
+	GLint num_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+	return num_formats > 0;
+}
 
-	return texture_id;
+size_t program_size(GLuint program_id)
+{
+	// Only drivers that can save program binaries report a size
+	if (!program_id || !program_binary_supported())
+	{
+		return 0;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+	return length;
 }
 
-GLuint load_shaders(const char * vertex_file_path,const char * fragment_file_path)
+static string program_cache_path(const char *cache_dir, uint64_t key)
 {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+	return string(cache_dir) + "/" + name;
+}
 
-	// Create the shaders
-	GLuint vertex_shader_id = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fragment_shader_id = glCreateShader(GL_FRAGMENT_SHADER);
+/// Try to restore a program from the cache. Returns 0 on a miss or if the driver rejects the binary.
+static GLuint load_program_binary(const string &path, uint64_t key, uint64_t &compile_us)
+{
+	string contents;
+	if (!read_file(path.c_str(), contents) || contents.size() <= sizeof(ProgramCacheHeader))
+	{
+		return 0;
+	}
 
-	// Read the Vertex Shader code from the file
-	string vertex_shader_code;
-	ifstream vertex_shader_stream(vertex_file_path, ios::in);
-	if(vertex_shader_stream.is_open())
+	ProgramCacheHeader header;
+	memcpy(&header, contents.data(), sizeof(header));
+	if (memcmp(header.magic, "GLPB", 4) != 0 || header.key != key)
 	{
-		string Line = "";
-		while(getline(vertex_shader_stream, Line))
-		{
-			vertex_shader_code += "\n" + Line;
-		}
-		vertex_shader_stream.close();
+		return 0;
 	}
-	else
+
+	GLuint program_id = glCreateProgram();
+	glProgramBinary(program_id, header.format, contents.data() + sizeof(header), contents.size() - sizeof(header));
+
+	GLint result = GL_FALSE;
+	glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+	if (!result)
 	{
-		cerr << "Impossible to open " << vertex_file_path << ". Are you in the right directory? Don't forget to read the FAQ!\n";
+		// Typically a driver update; fall back to compiling from source
+		cerr << "Cached program binary rejected by driver: " << path << endl;
+		glDeleteProgram(program_id);
 		return 0;
 	}
 
-	// Read the Fragment Shader code from the file
-	string fragment_shader_code;
-	ifstream fragment_shader_stream(fragment_file_path, ios::in);
-	if(fragment_shader_stream.is_open())
+	compile_us = header.compile_us;
+	return program_id;
+}
+
+static void save_program_binary(const char *cache_dir, const string &path, GLuint program_id, uint64_t key, uint64_t compile_us)
+{
+	GLint length = 0;
+	glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
 	{
-		string Line = "";
-		while(getline(fragment_shader_stream, Line))
-		{
-			fragment_shader_code += "\n" + Line;
-		}
-		fragment_shader_stream.close();
+		return;
 	}
 
-	GLint result = GL_FALSE;
-	int info_log_length;
+	ProgramCacheHeader header;
+	memcpy(header.magic, "GLPB", 4);
+	header.key = key;
+	header.compile_us = compile_us;
 
-	// Compile Vertex Shader
-	cout << "Compiling shader: " << vertex_file_path << endl;
-	char const * vertex_source_pointer = vertex_shader_code.c_str();
-	glShaderSource(vertex_shader_id, 1, &vertex_source_pointer , NULL);
-	glCompileShader(vertex_shader_id);
+	vector<char> binary(length);
+	glGetProgramBinary(program_id, length, NULL, &header.format, binary.data());
 
-	// Check Vertex Shader
-	glGetShaderiv(vertex_shader_id, GL_COMPILE_STATUS, &result);
-	glGetShaderiv(vertex_shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
-	if ( info_log_length > 0 )
+	mkdir(cache_dir, 0755);
+
+	// Write to a temporary file and rename so a partially written binary is never picked up
+	string tmp_path = path + ".tmp";
+	ofstream stream(tmp_path, ios::out | ios::binary);
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	stream.write(binary.data(), binary.size());
+	stream.close();
+
+	if (!stream || rename(tmp_path.c_str(), path.c_str()) != 0)
 	{
-		vector<char> vertex_shader_error_message(info_log_length+1);
-		glGetShaderInfoLog(vertex_shader_id, info_log_length, NULL, &vertex_shader_error_message[0]);
-		cerr << &vertex_shader_error_message[0] << endl;
+		cerr << "Failed to write program cache: " << path << endl;
+		remove(tmp_path.c_str());
 	}
-	if (!result)
+}
+
+GLuint load_shaders(const char *vertex_file_path, const char *fragment_file_path, unsigned features, const char *cache_dir)
+{
+	// Read the shader code from the files
+	string vertex_shader_code;
+	if (!read_file(vertex_file_path, vertex_shader_code))
 	{
+		cerr << "Impossible to open " << vertex_file_path << ". Are you in the right directory? Don't forget to read the FAQ!\n";
 		return 0;
 	}
 
-	// Compile Fragment Shader
-	cout << "Compiling shader: " << fragment_file_path << endl;
-	char const * fragment_source_pointer = fragment_shader_code.c_str();
-	glShaderSource(fragment_shader_id, 1, &fragment_source_pointer , NULL);
-	glCompileShader(fragment_shader_id);
+	string fragment_shader_code;
+	if (!read_file(fragment_file_path, fragment_shader_code))
+	{
+		cerr << "Impossible to open " << fragment_file_path << ". Are you in the right directory? Don't forget to read the FAQ!\n";
+		return 0;
+	}
 
-	// Check Fragment Shader
-	glGetShaderiv(fragment_shader_id, GL_COMPILE_STATUS, &result);
-	glGetShaderiv(fragment_shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
-	if ( info_log_length > 0 )
+	// Specialise the shaders for the requested features
+	string defines = shader_defines(features);
+	vertex_shader_code = inject_defines(vertex_shader_code, defines);
+	fragment_shader_code = inject_defines(fragment_shader_code, defines);
+	report_shader_cost(vertex_file_path, vertex_shader_code, features);
+	report_shader_cost(fragment_file_path, fragment_shader_code, features);
+
+	// Binaries are only valid for the exact driver that produced them so key on that as well as the source
+	bool use_cache = cache_dir && strlen(cache_dir) > 0 && program_binary_supported();
+	uint64_t key = 0;
+	string cache_path;
+	if (use_cache)
+	{
+		key = hash_fnv1a(vertex_shader_code);
+		key = hash_fnv1a(fragment_shader_code, key);
+		key = hash_fnv1a(gl_string(GL_VENDOR), key);
+		key = hash_fnv1a(gl_string(GL_RENDERER), key);
+		key = hash_fnv1a(gl_string(GL_VERSION), key);
+		cache_path = program_cache_path(cache_dir, key);
+
+		auto tp1 = chrono::steady_clock::now();
+		uint64_t compile_us = 0;
+		GLuint program_id = load_program_binary(cache_path, key, compile_us);
+		if (program_id)
+		{
+			auto load_us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - tp1).count();
+			cout << "Program cache hit: " << cache_path << " (loaded in " << load_us / 1000.0 << " ms, saved "
+				 << (static_cast<double>(compile_us) - load_us) / 1000.0 << " ms of compile time)\n";
+			return program_id;
+		}
+		cout << "Program cache miss: " << cache_path << endl;
+	}
+
+	auto tp1 = chrono::steady_clock::now();
+
+	// Compile the shaders
+	GLuint vertex_shader_id = compile_shader(GL_VERTEX_SHADER, vertex_file_path, vertex_shader_code);
+	if (!vertex_shader_id)
 	{
-		vector<char> fragment_shader_error_message(info_log_length+1);
-		glGetShaderInfoLog(fragment_shader_id, info_log_length, NULL, &fragment_shader_error_message[0]);
-		cerr << &fragment_shader_error_message[0] << endl;
+		return 0;
 	}
-	if (!result)
+
+	GLuint fragment_shader_id = compile_shader(GL_FRAGMENT_SHADER, fragment_file_path, fragment_shader_code);
+	if (!fragment_shader_id)
 	{
+		glDeleteShader(vertex_shader_id);
 		return 0;
 	}
 
 	// Link the program
 	cout << "Linking program\n";
 	GLuint program_id = glCreateProgram();
+	if (use_cache)
+	{
+		glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glAttachShader(program_id, vertex_shader_id);
 	glAttachShader(program_id, fragment_shader_id);
 	glLinkProgram(program_id);
 
 	// Check the program
+	GLint result = GL_FALSE;
+	int info_log_length;
 	glGetProgramiv(program_id, GL_LINK_STATUS, &result);
 	glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_log_length);
 	if ( info_log_length > 0 )
@@ -245,6 +522,19 @@ GLuint load_shaders(const char * vertex_file_path,const char * fragment_file_pat
 	glDeleteShader(vertex_shader_id);
 	glDeleteShader(fragment_shader_id);
 
+	if (!result)
+	{
+		glDeleteProgram(program_id);
+		return 0;
+	}
+
+	auto compile_us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - tp1).count();
+	cout << "Program compiled and linked in " << compile_us / 1000.0 << " ms\n";
+
+	if (use_cache)
+	{
+		save_program_binary(cache_dir, cache_path, program_id, key, compile_us);
+	}
+
 	return program_id;
 }
-
@@ -1,8 +1,40 @@
 #ifndef __UTILITY_HPP__
 #define __UTILITY_HPP__
 
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "png_image.hpp"
+
+/// Features used to specialise the shaders at compile time. Each is injected as a #define.
+enum ShaderFeature
+{
+	SHADER_TEXTURED    = 1 << 0,
+	SHADER_LIT         = 1 << 1,
+	SHADER_SPECULAR    = 1 << 2,
+	SHADER_ATTENUATION = 1 << 3,
+	SHADER_LIGHT_LIST  = 1 << 4,
+	SHADER_TILED       = 1 << 5,
+};
+
+GLuint create_texture(const PngImage &image);
+void update_texture(GLuint texture_id, const PngImage &image);
 GLuint load_png(const char *imagepath);
-GLuint load_shaders(const char * vertex_file_path,const char * fragment_file_path);
+
+// Sizes of GL objects in bytes
+size_t buffer_size(GLuint buffer_id);
+size_t texture_size(GLuint texture_id);
+size_t program_size(GLuint program_id);
+
+/// Estimated size of a texture created from the image
+size_t texture_size(const PngImage &image);
+
+/// 64-bit FNV-1a hash, used to key the program binary cache and chunk files. Pass the
+/// previous result as hash to continue it.
+uint64_t hash_fnv1a(const std::string &data, uint64_t hash = 14695981039346656037ULL);
+
+GLuint load_shaders(const char *vertex_file_path, const char *fragment_file_path, unsigned features = 0, const char *cache_dir = nullptr);
 
 #endif // __UTILITY_HPP__
 
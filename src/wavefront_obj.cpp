@@ -3,12 +3,21 @@
 #include <sstream>
 #include <limits>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include "wavefront_obj.hpp"
 
 using namespace std;
 
+/// Capacity of v once extra more values are pushed, assuming it doubles when full
+static size_t capacity_after(const vector<float> &v, size_t extra)
+{
+	size_t size = v.size() + extra;
+	return size <= v.capacity() ? v.capacity() : max(v.capacity() * 2, size);
+}
+
 /// Generate data from file
-void WavefrontObj::generate_data()
+void WavefrontObj::generate_data(MeshletMode meshlets)
 {
 	ifstream file(m_filename, ifstream::in);
 	string line;
@@ -18,6 +27,17 @@ void WavefrontObj::generate_data()
 	vector<float> tex_coords;
 	vector<float> normals;
 
+	// Memory is claimed before each array grows, so loading stops before going over a budget
+	MemoryUsage scratch(MEMORY_SCRATCH);
+	auto scratch_fits = [&](size_t v, size_t vt, size_t vn)
+	{
+		return scratch.try_set((capacity_after(vertices, v) + capacity_after(tex_coords, vt) + capacity_after(normals, vn)) * sizeof(float));
+	};
+	auto mesh_fits = [&](size_t v, size_t vt, size_t vn)
+	{
+		return m_memory.try_set((capacity_after(m_vertices, v) + capacity_after(m_tex_coords, vt) + capacity_after(m_normals, vn)) * sizeof(float));
+	};
+
 	while (file.good())
 	{
 		getline(file, line);
@@ -40,6 +60,11 @@ void WavefrontObj::generate_data()
 			x = y = z = 0.0f;
 			w = 1.0f;
 	  		in >> x >> y >> z >> w;
+			if (!scratch_fits(3, 0, 0))
+			{
+				m_over_budget = MEMORY_SCRATCH;
+				break;
+			}
 			vertices.push_back(x);
 			vertices.push_back(y);
 			vertices.push_back(z);
@@ -50,6 +75,11 @@ void WavefrontObj::generate_data()
 			float u, v, w;
 			u = v = w = 0.0f;
 			in >> u >> v >> w;
+			if (!scratch_fits(0, 2, 0))
+			{
+				m_over_budget = MEMORY_SCRATCH;
+				break;
+			}
 			tex_coords.push_back(u);
 			tex_coords.push_back(v);
 		}
@@ -59,6 +89,11 @@ void WavefrontObj::generate_data()
 			float dx, dy, dz;
 			dx = dy = dz = 0.0f;
 			in >> dx >> dy >> dz;
+			if (!scratch_fits(0, 0, 3))
+			{
+				m_over_budget = MEMORY_SCRATCH;
+				break;
+			}
 			normals.push_back(dx);
 			normals.push_back(dy);
 			normals.push_back(dz);
@@ -68,50 +103,44 @@ void WavefrontObj::generate_data()
 			vector<unsigned> f;
 			vector<unsigned> ft;
 			vector<unsigned> fn;
-			unsigned tmp;
+			parse_face(in, f, ft, fn);
 
-			while (!in.eof())
+			// Skip faces that refer to attributes that don't exist, or that are cut off part way,
+			// e.g. if the file is still being written
+			bool valid = (ft.empty() || ft.size() == f.size()) && (fn.empty() || fn.size() == f.size());
+			for (size_t i=0; i<f.size(); i++)
 			{
-				// Vertex
-				in >> tmp;
-				f.push_back(tmp);
-
-				// Texture coordinate
-				if (in.peek() != '/')
-				{
-					continue;
-				}
-				else
-				{
-					in.ignore();
-					if (in.peek() != '/')
-					{
-						in >> tmp;
-						ft.push_back(tmp);
-					}
-				}
+				valid = valid && f[i] >= 1 && static_cast<size_t>(f[i]) * 3 <= vertices.size();
+			}
+			for (size_t i=0; i<ft.size(); i++)
+			{
+				valid = valid && ft[i] >= 1 && static_cast<size_t>(ft[i]) * 2 <= tex_coords.size();
+			}
+			for (size_t i=0; i<fn.size(); i++)
+			{
+				valid = valid && fn[i] >= 1 && static_cast<size_t>(fn[i]) * 3 <= normals.size();
+			}
 
-				// Normal
-				if (in.peek() != '/')
-				{
-					continue;
-				}
-				else
-				{
-					in.ignore();
-					in >> tmp;
-					fn.push_back(tmp);
-				}
+			if (!valid)
+			{
+				cerr << m_filename << ":" << line_num << ": face is cut off or out of range, skipping\n";
+				continue;
 			}
 
 			// Now store values
 			// Assume only triangles for now
 			if (f.size() >= 3)
 			{
+				if (!mesh_fits(9, ft.empty() ? 0 : 6, fn.empty() ? 0 : 9))
+				{
+					m_over_budget = MEMORY_MESH_CPU;
+					break;
+				}
+
 				// OBJ indices start at 1 not zero
 				for (int i=0; i<3; i++)
 				{
-					size_t findex = (f[i]-1) * 3;
+					size_t findex = (static_cast<size_t>(f[i]) - 1) * 3;
 					m_vertices.push_back(vertices[findex+0]); // X
 					m_vertices.push_back(vertices[findex+1]); // Y
 					m_vertices.push_back(vertices[findex+2]); // Z
@@ -121,7 +150,7 @@ void WavefrontObj::generate_data()
 				{
 					for (int i=0; i<3; i++)
 					{
-						size_t findex = (ft[i]-1) * 2;
+						size_t findex = (static_cast<size_t>(ft[i]) - 1) * 2;
 						m_tex_coords.push_back(tex_coords[findex+0]); // U
 						m_tex_coords.push_back(tex_coords[findex+1]); // V
 					}
@@ -131,7 +160,7 @@ void WavefrontObj::generate_data()
 				{
 					for (int i=0; i<3; i++)
 					{
-						size_t findex = (fn[i]-1) * 3;
+						size_t findex = (static_cast<size_t>(fn[i]) - 1) * 3;
 						m_normals.push_back(normals[findex+0]); // dX
 						m_normals.push_back(normals[findex+1]); // dY
 						m_normals.push_back(normals[findex+2]); // dZ
@@ -140,36 +169,119 @@ void WavefrontObj::generate_data()
 			}
 		}
 	}
+
+	if (m_over_budget != MEMORY_CATEGORIES)
+	{
+		release_data();
+		return;
+	}
+
+	// Faces with texture coords or normals on only some faces would misalign the arrays
+	if (m_tex_coords.size() / 2 != m_vertices.size() / 3)
+	{
+		m_tex_coords.clear();
+	}
+	if (m_normals.size() != m_vertices.size())
+	{
+		m_normals.clear();
+	}
+
+	m_num_vertices = m_vertices.size() / 3;
+	m_has_tex_coords = !m_tex_coords.empty();
+	m_has_normals = !m_normals.empty();
+	m_scaler = compute_scaler(m_vertices);
+	m_memory.set((m_vertices.capacity() + m_tex_coords.capacity() + m_normals.capacity()) * sizeof(float));
+
+	if (meshlets != MESHLETS_NONE)
+	{
+		m_meshlets.build(m_vertices, m_tex_coords, m_normals, meshlets == MESHLETS_SORTED);
+	}
 }
 
-GLuint WavefrontObj::create_vertex_buffer()
+void WavefrontObj::parse_face(istream &in, vector<unsigned> &f, vector<unsigned> &ft, vector<unsigned> &fn)
 {
-	GLuint id;
-	glGenBuffers(1, &id);
-	glBindBuffer(GL_ARRAY_BUFFER, id);
-	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
-	return id;
+	unsigned tmp;
+
+	while (!in.eof())
+	{
+		// Vertex. Stop at trailing space or anything that isn't a number.
+		if (!(in >> tmp))
+		{
+			break;
+		}
+		f.push_back(tmp);
+
+		// Texture coordinate
+		if (in.peek() != '/')
+		{
+			continue;
+		}
+		else
+		{
+			in.ignore();
+			if (in.peek() != '/')
+			{
+				if (!(in >> tmp))
+				{
+					break;
+				}
+				ft.push_back(tmp);
+			}
+		}
+
+		// Normal
+		if (in.peek() != '/')
+		{
+			continue;
+		}
+		else
+		{
+			in.ignore();
+			if (!(in >> tmp))
+			{
+				break;
+			}
+			fn.push_back(tmp);
+		}
+	}
 }
 
-GLuint WavefrontObj::create_tex_coord_buffer()
+void WavefrontObj::changed_ranges(const vector<float> &resident, const vector<float> &data, vector<pair<size_t, size_t> > &ranges)
 {
-	GLuint id;
-	glGenBuffers(1, &id);
-	glBindBuffer(GL_ARRAY_BUFFER, id);
-	glBufferData(GL_ARRAY_BUFFER, m_tex_coords.size() * sizeof(float), m_tex_coords.data(), GL_STATIC_DRAW);
-	return id;
+	// Compare in blocks and merge neighbouring changed blocks into a single range
+	const size_t block_size = 4096;
+	const size_t none = numeric_limits<size_t>::max();
+	size_t range_start = none;
+
+	// One extra iteration past the end flushes the last range
+	for (size_t i=0; i<data.size()+block_size; i+=block_size)
+	{
+		size_t end = min(i + block_size, data.size());
+		bool changed = (i < data.size()) &&
+			(end > resident.size() || memcmp(&data[i], &resident[i], (end - i) * sizeof(float)) != 0);
+
+		if (changed && range_start == none)
+		{
+			range_start = i;
+		}
+		else if (!changed && range_start != none)
+		{
+			ranges.push_back(make_pair(range_start, min(i, data.size()) - range_start));
+			range_start = none;
+		}
+	}
 }
 
-GLuint WavefrontObj::create_normal_buffer()
+void WavefrontObj::release_data()
 {
-	GLuint id;
-	glGenBuffers(1, &id);
-	glBindBuffer(GL_ARRAY_BUFFER, id);
-	glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(float), m_normals.data(), GL_STATIC_DRAW);
-	return id;
+	// Swap rather than clear so the memory is actually freed
+	vector<float>().swap(m_vertices);
+	vector<float>().swap(m_tex_coords);
+	vector<float>().swap(m_normals);
+	m_memory.set(0);
 }
 
-float WavefrontObj::get_scaler()
+float WavefrontObj::compute_scaler(const vector<float> &vertices)
 {
 	// The scaler tries to give an idea of how to scale the box based on the diagonal length
 	// of a cube that tightly surrounds the object. This enables the program to try and scale
@@ -182,15 +294,15 @@ float WavefrontObj::get_scaler()
 	float ymax = numeric_limits<float>::min();
 	float zmax = numeric_limits<float>::min();
 
-	const size_t count = m_vertices.size();
+	const size_t count = vertices.size();
 	for (size_t i = 0; i<count; i+=3)
 	{
-		xmin = min(xmin, m_vertices[i+0]);
-		xmax = max(xmax, m_vertices[i+0]);
-		ymin = min(ymin, m_vertices[i+1]);
-		ymax = max(ymax, m_vertices[i+1]);
-		zmin = min(zmin, m_vertices[i+2]);
-		zmax = max(zmax, m_vertices[i+2]);
+		xmin = min(xmin, vertices[i+0]);
+		xmax = max(xmax, vertices[i+0]);
+		ymin = min(ymin, vertices[i+1]);
+		ymax = max(ymax, vertices[i+1]);
+		zmin = min(zmin, vertices[i+2]);
+		zmax = max(zmax, vertices[i+2]);
 	}
 
 	float x = xmax - xmin;
@@ -3,6 +3,11 @@
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <istream>
+
+#include "meshlet.hpp"
+#include "memory_tracker.hpp"
 
 extern "C"
 {
@@ -10,6 +15,14 @@ extern "C"
 #include <GL/glew.h>
 }
 
+/// How triangles are ordered and clustered into meshlets on load
+enum MeshletMode
+{
+	MESHLETS_SORTED,     // sorted spatially, for the tightest meshlets
+	MESHLETS_FILE_ORDER, // in file order, so reloading an edited file only changes what was edited
+	MESHLETS_NONE,       // in file order without meshlets, for callers that don't cull
+};
+
 /**
  * Class for wavefront object type.
  */
@@ -17,31 +30,80 @@ class WavefrontObj
 {
 public:
 	/// Constructors.
-	WavefrontObj(const char *filename) : m_filename(filename) { generate_data(); }
+	WavefrontObj(const char *filename, MeshletMode meshlets = MESHLETS_SORTED) : m_filename(filename) { generate_data(meshlets); }
 
 	/// Destructors.
 	~WavefrontObj() {}
 
 	void dump();
-	size_t num_vertices() const { return m_vertices.size(); }
+	size_t num_vertices() const { return m_num_vertices; }
+	size_t num_triangles() const { return m_num_vertices / 3; }
+	bool has_tex_coords() const { return m_has_tex_coords; }
+	bool has_normals() const { return m_has_normals; }
+
+	// Category whose budget stopped loading, or MEMORY_CATEGORIES if the whole file loaded.
+	// The object is empty if loading stopped.
+	MemoryCategory over_budget() const { return m_over_budget; }
+
+	// Expanded attribute data, three vertices per triangle. Empty after release_data().
+	const std::vector<float> &vertices() const { return m_vertices; }
+	const std::vector<float> &tex_coords() const { return m_tex_coords; }
+	const std::vector<float> &normals() const { return m_normals; }
+
+	// Clusters of triangles for culling
+	const Meshlets &meshlets() const { return m_meshlets; }
 
 	// Create GL buffers
 	GLuint create_vertex_buffer();
 	GLuint create_tex_coord_buffer();
 	GLuint create_normal_buffer();
 
+	// Update GL buffers holding the resident object's data to hold this object's data.
+	// Returns the number of bytes uploaded.
+	size_t update_vertex_buffer(GLuint id, const WavefrontObj &resident) const;
+	size_t update_tex_coord_buffer(GLuint id, const WavefrontObj &resident) const;
+	size_t update_normal_buffer(GLuint id, const WavefrontObj &resident) const;
+
+	// Bytes of attribute data, as the GL buffers will hold
+	size_t data_bytes() const { return (m_vertices.size() + m_tex_coords.size() + m_normals.size()) * sizeof(float); }
+
+	// Free the attribute data once it has been uploaded. The counts, scale and meshlets are
+	// kept, but the object can no longer be the resident object in the update_*_buffer functions.
+	void release_data();
+
 	// Get scale value
-	float get_scaler();
+	float get_scaler() const { return m_scaler; }
+
+	// Diagonal length of the bounding box of the vertices, which get_scaler() returns
+	static float compute_scaler(const std::vector<float> &vertices);
+
+	// Find the (offset, count) ranges of data that differ from resident
+	static void changed_ranges(const std::vector<float> &resident, const std::vector<float> &data,
+							   std::vector<std::pair<size_t, size_t> > &ranges);
+
+	// Parse the rest of an "f" line into the vertex, texture coordinate and normal indices.
+	// Stops at anything that is not an index. Indices start at 1 and are not checked.
+	static void parse_face(std::istream &in, std::vector<unsigned> &f, std::vector<unsigned> &ft, std::vector<unsigned> &fn);
 	
 private:
 	/// Generate data from file
-	void generate_data();
+	void generate_data(MeshletMode meshlets);
+
+	/// Upload only the ranges of data that differ from resident
+	static size_t update_buffer(GLuint id, const std::vector<float> &resident, const std::vector<float> &data);
 
 	/// Instance variables
 	const char *m_filename;
 	std::vector<float> m_vertices;
 	std::vector<float> m_tex_coords;
 	std::vector<float> m_normals;
+	Meshlets m_meshlets;
+	size_t m_num_vertices = 0;
+	bool m_has_tex_coords = false;
+	bool m_has_normals = false;
+	float m_scaler = 0.0f;
+	MemoryUsage m_memory{MEMORY_MESH_CPU};
+	MemoryCategory m_over_budget = MEMORY_CATEGORIES;
 };
 
 #endif // __WAVEFRONT_OBJ_HPP__
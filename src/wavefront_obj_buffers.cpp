@@ -0,0 +1,72 @@
+#include "wavefront_obj.hpp"
+
+using namespace std;
+
+// The GL side of WavefrontObj, kept apart so the parsing can be used without linking GL
+
+GLuint WavefrontObj::create_vertex_buffer()
+{
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
+	return id;
+}
+
+GLuint WavefrontObj::create_tex_coord_buffer()
+{
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	glBufferData(GL_ARRAY_BUFFER, m_tex_coords.size() * sizeof(float), m_tex_coords.data(), GL_STATIC_DRAW);
+	return id;
+}
+
+GLuint WavefrontObj::create_normal_buffer()
+{
+	GLuint id;
+	glGenBuffers(1, &id);
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+	glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(float), m_normals.data(), GL_STATIC_DRAW);
+	return id;
+}
+
+size_t WavefrontObj::update_vertex_buffer(GLuint id, const WavefrontObj &resident) const
+{
+	return update_buffer(id, resident.m_vertices, m_vertices);
+}
+
+size_t WavefrontObj::update_tex_coord_buffer(GLuint id, const WavefrontObj &resident) const
+{
+	return update_buffer(id, resident.m_tex_coords, m_tex_coords);
+}
+
+size_t WavefrontObj::update_normal_buffer(GLuint id, const WavefrontObj &resident) const
+{
+	return update_buffer(id, resident.m_normals, m_normals);
+}
+
+size_t WavefrontObj::update_buffer(GLuint id, const vector<float> &resident, const vector<float> &data)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, id);
+
+	// Reallocate if the data no longer fits
+	GLint capacity = 0;
+	glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &capacity);
+	if (data.size() * sizeof(float) > static_cast<size_t>(capacity))
+	{
+		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), data.data(), GL_STATIC_DRAW);
+		return data.size() * sizeof(float);
+	}
+
+	size_t uploaded = 0;
+	vector<pair<size_t, size_t> > ranges;
+	changed_ranges(resident, data, ranges);
+	for (auto &range : ranges)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(float), range.second * sizeof(float), &data[range.first]);
+		uploaded += range.second * sizeof(float);
+	}
+
+	return uploaded;
+}